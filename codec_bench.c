@@ -0,0 +1,281 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <time.h>
+
+#include "crowd_codec.h"
+
+/*
+ * 선로 부호/디코더 퍼징 + 처리량 벤치마크 (모듈 없이 빌드 머신에서 실행)
+ * crowd_encode_word로 만든 펄스열을 에지마다 지터를 준 타임스탬프로 바꾸고,
+ * 일부 프레임에는 비트 반전 / 펄스 누락 / 글리치를 넣어 crowd_decoder_feed에 입력한다.
+ *   - 정상/글리치 프레임: 보낸 워드가 정확히 한 번 복원되어야 함
+ *   - 비트 반전 프레임: CRC를 통과하는 워드가 나오면 안 됨
+ *   - 펄스 누락 프레임: 워드가 나오면 안 됨
+ * 위반이 하나라도 있으면 종료 코드 1 (프로토콜 변경 게이트용).
+ */
+
+#define UNIT_NS 1000ULL         /* 디코더는 단위 비율만 보므로 값 자체는 무관 */
+#define CHUNK_FRAMES 1024
+#define MAX_EDGES_PER_FRAME ((CROWD_MAX_PULSES + 1) * 2)
+#define MAX_JITTER_PCT 24       /* 펄스 폭 오차 2J가 0.5단위 미만이어야 판정 가능 */
+#define MAX_REPORTS 10
+
+enum {
+    FUZZ_CLEAN,
+    FUZZ_FLIP,
+    FUZZ_DROP,
+    FUZZ_GLITCH,
+    FUZZ_KINDS,
+};
+
+static const char *fuzz_names[FUZZ_KINDS] = { "정상", "비트 반전", "펄스 누락", "글리치" };
+
+struct edge {
+    uint64_t ts_ns;
+    uint8_t level;
+    uint8_t symbol;
+};
+
+struct frame_case {
+    uint32_t word;
+    int kind;
+    int edge_end;               /* 이 프레임의 마지막 에지 다음 인덱스 */
+    int words;                  /* 디코더가 완성한 워드 수 */
+    int valid;                  /* 그중 CRC 통과 */
+    int matched;                /* 그중 보낸 워드와 일치 */
+};
+
+static uint64_t rng_state = 0x9e3779b97f4a7c15ULL;
+
+uint64_t rng_next(void) {
+    rng_state ^= rng_state << 13;
+    rng_state ^= rng_state >> 7;
+    rng_state ^= rng_state << 17;
+    return rng_state;
+}
+
+uint32_t rng_below(uint32_t n) {
+    return (uint32_t)(rng_next() % n);
+}
+
+uint64_t now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+void print_usage(const char *prog_name) {
+    printf("사용법: %s [옵션]\n", prog_name);
+    printf("옵션:\n");
+    printf("  -n N          프레임 수 (기본 200000)\n");
+    printf("  -j PCT        에지마다 ±PCT%% 단위 지터 (기본 20, 최대 %d)\n", MAX_JITTER_PCT);
+    printf("  -e PCT        손상 프레임 비율 (기본 10, 반전/누락/글리치 균등)\n");
+    printf("  -w BITS       버스 심볼 폭 (0: 펄스 폭 직렬 부호, 1/2/3/4/6/8, 기본 0)\n");
+    printf("  -s SEED       난수 시드 (기본 1)\n");
+    printf("  -h, --help    도움말\n");
+}
+
+/* 프레임 하나를 에지 열로 바꿈. 반환값은 추가한 에지 수 */
+int build_frame(struct edge *out, uint64_t *t, struct frame_case *fc,
+                unsigned int symbol_bits, uint64_t jitter_ns) {
+    struct crowd_frame frame = {
+        .type = 1 + rng_below(4),
+        .seq = rng_below(CROWD_SEQ_SPACE),
+        .node = rng_below(256),
+    };
+    struct crowd_pulse pulses[CROWD_MAX_PULSES];
+    int n, target, count = 0;
+
+    fc->word = crowd_frame_pack(&frame);
+    n = crowd_encode_word(fc->word, symbol_bits, pulses);
+
+    /* 비트 반전은 데이터 펄스에만, 누락/글리치는 프리앰블 포함 아무 펄스 */
+    target = fc->kind == FUZZ_FLIP ? 1 + (int)rng_below(n - 1) : (int)rng_below(n);
+
+    for (int i = 0; i < n; i++) {
+        uint64_t high = pulses[i].high_units;
+        uint8_t symbol = pulses[i].symbol;
+
+        if (i == target && fc->kind == FUZZ_DROP) {
+            *t += (high + 1) * UNIT_NS;
+            continue;
+        }
+        if (i == target && fc->kind == FUZZ_FLIP) {
+            if (symbol_bits)
+                symbol ^= 1U << rng_below(symbol_bits);
+            else
+                high = high == CROWD_ONE_UNITS ? CROWD_ZERO_UNITS : CROWD_ONE_UNITS;
+        }
+
+        out[count].ts_ns = *t + rng_below(2 * jitter_ns + 1) - jitter_ns;
+        out[count].level = 1;
+        out[count++].symbol = symbol;
+        out[count].ts_ns = *t + high * UNIT_NS + rng_below(2 * jitter_ns + 1) - jitter_ns;
+        out[count].level = 0;
+        out[count++].symbol = 0;
+        *t += (high + 1) * UNIT_NS;
+
+        /* LOW 구간 한가운데 0.2단위 스파이크 (버스 모드면 엉뚱한 심볼까지 래치) */
+        if (i == target && fc->kind == FUZZ_GLITCH) {
+            out[count].ts_ns = *t - UNIT_NS * 6 / 10;
+            out[count].level = 1;
+            out[count++].symbol = symbol_bits ? rng_below(1U << symbol_bits) : 0;
+            out[count].ts_ns = *t - UNIT_NS * 4 / 10;
+            out[count].level = 0;
+            out[count++].symbol = 0;
+        }
+    }
+    *t += CROWD_IFG_UNITS * UNIT_NS;
+    return count;
+}
+
+int check_frame(const struct frame_case *fc) {
+    switch (fc->kind) {
+    case FUZZ_CLEAN:
+    case FUZZ_GLITCH:
+        return fc->words == 1 && fc->matched == 1;
+    case FUZZ_FLIP:
+        return fc->valid == 0;
+    case FUZZ_DROP:
+        return fc->words == 0;
+    }
+    return 0;
+}
+
+int main(int argc, char *argv[]) {
+    long num_frames = 200000;
+    int jitter_pct = 20;
+    int error_pct = 10;
+    int symbol_bits = 0;
+    unsigned long seed = 1;
+
+    // 명령행 인수 처리
+    for (int i = 1; i < argc; i++) {
+        const char *val = (i + 1 < argc) ? argv[i + 1] : NULL;
+
+        if (strcmp(argv[i], "-n") == 0 && val) {
+            num_frames = atol(val); i++;
+        } else if (strcmp(argv[i], "-j") == 0 && val) {
+            jitter_pct = atoi(val); i++;
+        } else if (strcmp(argv[i], "-e") == 0 && val) {
+            error_pct = atoi(val); i++;
+        } else if (strcmp(argv[i], "-w") == 0 && val) {
+            symbol_bits = atoi(val); i++;
+        } else if (strcmp(argv[i], "-s") == 0 && val) {
+            seed = strtoul(val, NULL, 0); i++;
+        } else if (strcmp(argv[i], "-h") == 0 || strcmp(argv[i], "--help") == 0) {
+            print_usage(argv[0]);
+            return 0;
+        } else {
+            print_usage(argv[0]);
+            return 1;
+        }
+    }
+
+    if (num_frames <= 0 || jitter_pct < 0 || jitter_pct > MAX_JITTER_PCT ||
+        error_pct < 0 || error_pct > 100 || symbol_bits < 0 || symbol_bits > 8 ||
+        (symbol_bits && CROWD_FRAME_BITS % symbol_bits)) {
+        printf("잘못된 인수\n");
+        return 1;
+    }
+    if (seed) rng_state ^= seed * 0x2545f4914f6cdd1dULL;
+
+    struct edge *edges = malloc(sizeof(*edges) * CHUNK_FRAMES * MAX_EDGES_PER_FRAME);
+    struct frame_case *cases = malloc(sizeof(*cases) * CHUNK_FRAMES);
+    if (!edges || !cases) {
+        printf("메모리 부족\n");
+        return 1;
+    }
+
+    printf("IoT 혼잡도 시스템 - 선로 부호 디코더 퍼징/벤치마크\n");
+    printf("%s, 프레임 %ld개, 지터 ±%d%%, 손상 %d%%, 시드 %lu\n",
+           symbol_bits ? "버스 모드" : "직렬 모드", num_frames, jitter_pct, error_pct, seed);
+    if (symbol_bits) printf("심볼 폭 %d비트\n", symbol_bits);
+    printf("=====================================\n");
+
+    struct crowd_decoder dec = { .symbol_bits = symbol_bits };
+    uint64_t jitter_ns = UNIT_NS * jitter_pct / 100;
+    uint64_t t = UNIT_NS;
+    uint64_t decode_ns = 0;
+    unsigned long total_edges = 0, framing_errors = 0, crc_errors = 0;
+    unsigned long per_kind[FUZZ_KINDS] = {0}, failed[FUZZ_KINDS] = {0};
+    unsigned long violations = 0;
+
+    crowd_decoder_reset(&dec);
+
+    for (long done = 0; done < num_frames; done += CHUNK_FRAMES) {
+        int frames = num_frames - done < CHUNK_FRAMES ? (int)(num_frames - done) : CHUNK_FRAMES;
+        int count = 0;
+
+        for (int f = 0; f < frames; f++) {
+            struct frame_case *fc = &cases[f];
+
+            memset(fc, 0, sizeof(*fc));
+            fc->kind = (int)rng_below(100) < error_pct ? FUZZ_FLIP + (int)rng_below(3) : FUZZ_CLEAN;
+            count += build_frame(&edges[count], &t, fc, symbol_bits, jitter_ns);
+            fc->edge_end = count;
+        }
+
+        /* 측정 구간: 디코딩 + CRC 확인만 */
+        uint64_t start = now_ns();
+        int f = 0;
+        for (int i = 0; i < count; i++) {
+            struct crowd_frame frame;
+            uint32_t word;
+            int ret;
+
+            while (i >= cases[f].edge_end) f++;
+
+            ret = crowd_decoder_feed(&dec, edges[i].level, edges[i].ts_ns, UNIT_NS,
+                                     edges[i].symbol, &word);
+            if (ret < 0) {
+                framing_errors++;
+                continue;
+            }
+            if (ret == 0) continue;
+
+            cases[f].words++;
+            if (crowd_frame_unpack(word, &frame) < 0) {
+                crc_errors++;
+                continue;
+            }
+            cases[f].valid++;
+            if (word == cases[f].word) cases[f].matched++;
+        }
+        decode_ns += now_ns() - start;
+        total_edges += count;
+
+        for (f = 0; f < frames; f++) {
+            struct frame_case *fc = &cases[f];
+
+            per_kind[fc->kind]++;
+            if (check_frame(fc)) continue;
+
+            failed[fc->kind]++;
+            if (violations++ < MAX_REPORTS) {
+                printf("  ✗ 프레임 %ld (%s): 워드 0x%06x, 복원 %d개, CRC 통과 %d개, 일치 %d개\n",
+                       done + f, fuzz_names[fc->kind], fc->word, fc->words, fc->valid, fc->matched);
+            }
+        }
+    }
+
+    double sec = decode_ns / 1e9;
+    printf("\n=== 처리량 (디코딩 %.3f초) ===\n", sec);
+    printf("  에지   %12lu개  %12.0f edges/s  (%.1f ns/edge)\n",
+           total_edges, total_edges / sec, (double)decode_ns / total_edges);
+    printf("  프레임 %12ld개  %12.0f frames/s\n", num_frames, num_frames / sec);
+
+    printf("\n=== 정확성 ===\n");
+    for (int k = 0; k < FUZZ_KINDS; k++) {
+        printf("  %-10s %10lu개  위반 %lu개 %s\n",
+               fuzz_names[k], per_kind[k], failed[k], failed[k] ? "✗" : "✓");
+    }
+    printf("  프레이밍 오류 %lu회, CRC 오류 %lu회\n", framing_errors, crc_errors);
+
+    free(edges);
+    free(cases);
+
+    return violations ? 1 : 0;
+}
@@ -0,0 +1,144 @@
+/*
+ * 링크 프레임 부호화/복호화 (커널 모듈과 사용자 공간 공용, crowd_codec.h 참고)
+ */
+#ifdef __KERNEL__
+#include <linux/errno.h>
+#else
+#include <errno.h>
+#endif
+
+#include "crowd_codec.h"
+
+/* CRC-8 (다항식 0x07) */
+uint8_t crowd_crc8(const uint8_t *data, size_t len) {
+    uint8_t crc = 0;
+    size_t i;
+    int bit;
+
+    for (i = 0; i < len; i++) {
+        crc ^= data[i];
+        for (bit = 0; bit < 8; bit++)
+            crc = (crc & 0x80) ? (crc << 1) ^ 0x07 : crc << 1;
+    }
+    return crc;
+}
+
+uint32_t crowd_frame_pack(const struct crowd_frame *frame) {
+    uint8_t hdr[2];
+
+    hdr[0] = (frame->type << 4) | (frame->seq & (CROWD_SEQ_SPACE - 1));
+    hdr[1] = frame->node;
+
+    return ((uint32_t)hdr[0] << 16) | (hdr[1] << 8) | crowd_crc8(hdr, sizeof(hdr));
+}
+
+int crowd_frame_unpack(uint32_t word, struct crowd_frame *frame) {
+    uint8_t hdr[2] = { (word >> 16) & 0xff, (word >> 8) & 0xff };
+
+    if (crowd_crc8(hdr, sizeof(hdr)) != (word & 0xff))
+        return -EBADMSG;
+
+    frame->type = hdr[0] >> 4;
+    frame->seq = hdr[0] & (CROWD_SEQ_SPACE - 1);
+    frame->node = hdr[1];
+    return 0;
+}
+
+/*
+ * 24비트 워드를 펄스열로 바꾼다. pulses[0]은 항상 프리앰블.
+ * symbol_bits가 0이면 펄스 폭 직렬 부호, N이면 펄스마다 N비트 심볼 (24의 약수).
+ * 펄스 개수를 반환 (최대 CROWD_MAX_PULSES).
+ */
+int crowd_encode_word(uint32_t word, unsigned int symbol_bits, struct crowd_pulse *pulses) {
+    int n = 0;
+    int shift;
+
+    pulses[n].high_units = CROWD_PREAMBLE_UNITS;
+    pulses[n++].symbol = 0;
+
+    if (!symbol_bits) {
+        for (shift = CROWD_FRAME_BITS - 1; shift >= 0; shift--) {
+            pulses[n].high_units = (word >> shift) & 1 ? CROWD_ONE_UNITS : CROWD_ZERO_UNITS;
+            pulses[n++].symbol = 0;
+        }
+        return n;
+    }
+
+    for (shift = CROWD_FRAME_BITS - symbol_bits; shift >= 0; shift -= symbol_bits) {
+        pulses[n].high_units = 1;
+        pulses[n++].symbol = (word >> shift) & ((1U << symbol_bits) - 1);
+    }
+    return n;
+}
+
+void crowd_decoder_reset(struct crowd_decoder *dec) {
+    dec->state = CROWD_DEC_IDLE;
+    dec->high = false;
+    dec->nbits = 0;
+}
+
+/*
+ * 에지 하나를 디코더에 입력한다. symbol은 버스 모드에서 상승 에지에 래치한 값.
+ * 24비트 워드가 완성되면 1, 진행 중이면 0, 프레이밍 오류면 -EPROTO.
+ */
+int crowd_decoder_feed(struct crowd_decoder *dec, int level, uint64_t ts_ns,
+                       uint64_t unit_ns, uint32_t symbol, uint32_t *word) {
+    uint64_t width;
+
+    if (level) {
+        dec->high = true;
+        dec->rise_ns = ts_ns;
+        dec->symbol = symbol;
+
+        /* 데이터 구간에서 LOW가 너무 길면 프레임 폐기 */
+        if (dec->state == CROWD_DEC_DATA && ts_ns - dec->fall_ns > 3 * unit_ns) {
+            dec->state = CROWD_DEC_IDLE;
+            return -EPROTO;
+        }
+        return 0;
+    }
+
+    /* 상승 에지를 놓친 하강 에지는 폭을 알 수 없으므로 무시 */
+    if (!dec->high)
+        return 0;
+
+    dec->high = false;
+    dec->fall_ns = ts_ns;
+    width = ts_ns - dec->rise_ns;
+
+    if (width < unit_ns / 2)        /* 글리치 */
+        return 0;
+
+    if (width >= 3 * unit_ns) {
+        if (width < 6 * unit_ns) {  /* 프리앰블 - 새 프레임 시작 */
+            bool aborted = dec->state == CROWD_DEC_DATA;
+
+            dec->state = CROWD_DEC_DATA;
+            dec->bits = 0;
+            dec->nbits = 0;
+            return aborted ? -EPROTO : 0;
+        }
+        if (dec->state == CROWD_DEC_DATA) {
+            dec->state = CROWD_DEC_IDLE;
+            return -EPROTO;
+        }
+        return 0;
+    }
+
+    if (dec->state != CROWD_DEC_DATA)
+        return 0;
+
+    if (dec->symbol_bits) {
+        dec->bits = (dec->bits << dec->symbol_bits) | dec->symbol;
+        dec->nbits += dec->symbol_bits;
+    } else {
+        dec->bits = (dec->bits << 1) | (width >= unit_ns * 3 / 2);
+        dec->nbits++;
+    }
+    if (dec->nbits < CROWD_FRAME_BITS)
+        return 0;
+
+    dec->state = CROWD_DEC_IDLE;
+    *word = dec->bits;
+    return 1;
+}
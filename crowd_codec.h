@@ -0,0 +1,85 @@
+/*
+ * 링크 프레임 부호화/복호화 (커널 모듈과 사용자 공간 공용)
+ *
+ * 커널 헤더나 libc 기능에 의존하지 않아 crowd_driver, crowd_rx,
+ * crowd_codec_bench에 같은 소스로 들어간다.
+ *
+ * 링크 프레임 (24비트, MSB 우선)
+ *   [23:20] 타입  [19:16] 시퀀스  [15:8] 노드 ID  [7:0] CRC-8
+ *
+ * 선로 부호화 (펄스 폭, 단위 = bit_unit_us):
+ *   프리앰블 HIGH 4단위, 비트 0 = HIGH 1단위, 비트 1 = HIGH 2단위
+ *   각 펄스 뒤에는 LOW 1단위, 프레임 뒤에는 LOW 2단위
+ *
+ * 버스 모드: 스트로브 라인에 프리앰블(4단위) 후 심볼마다 1단위 펄스,
+ *   데이터 라인 묶음(1~8개)의 값을 스트로브 상승 에지에서 래치.
+ *   프레임 형식과 CRC는 직렬 모드와 같다.
+ */
+#ifndef CROWD_CODEC_H
+#define CROWD_CODEC_H
+
+#ifdef __KERNEL__
+#include <linux/types.h>
+#else
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#endif
+
+#define CROWD_FRAME_ENTER 1
+#define CROWD_FRAME_EXIT 2
+#define CROWD_FRAME_STATUS 3
+#define CROWD_FRAME_ACK 4
+#define CROWD_FRAME_SYNC 5             /* 송신측 재시작: 수신측 시퀀스 기준점 재설정 */
+
+#define CROWD_FRAME_BITS 24
+#define CROWD_SEQ_SPACE 16          /* 4비트 시퀀스 */
+#define CROWD_PREAMBLE_UNITS 4
+#define CROWD_ZERO_UNITS 1
+#define CROWD_ONE_UNITS 2
+#define CROWD_IFG_UNITS 2           /* 프레임 간 휴지 */
+
+/* 프리앰블 + 비트마다 펄스 하나 (직렬 모드가 최대) */
+#define CROWD_MAX_PULSES (1 + CROWD_FRAME_BITS)
+
+/* 수신된 프레임 (CRC 검증 후) */
+struct crowd_frame {
+    uint8_t type;
+    uint8_t seq;
+    uint8_t node;
+};
+
+/* 송신 펄스: 버스 모드면 symbol을 데이터 라인에 올린 뒤 HIGH high_units, LOW 1단위 */
+struct crowd_pulse {
+    uint8_t high_units;
+    uint8_t symbol;
+};
+
+/* 펄스 폭 디코더 상태 */
+enum {
+    CROWD_DEC_IDLE,
+    CROWD_DEC_DATA,
+};
+
+struct crowd_decoder {
+    int state;
+    bool high;
+    uint64_t rise_ns;
+    uint64_t fall_ns;
+    uint32_t bits;
+    int nbits;
+    unsigned int symbol_bits;   /* 0: 펄스 폭 직렬 부호, N: 펄스마다 N비트 래치 */
+    uint32_t symbol;
+};
+
+uint8_t crowd_crc8(const uint8_t *data, size_t len);
+uint32_t crowd_frame_pack(const struct crowd_frame *frame);
+int crowd_frame_unpack(uint32_t word, struct crowd_frame *frame);
+
+int crowd_encode_word(uint32_t word, unsigned int symbol_bits, struct crowd_pulse *pulses);
+
+void crowd_decoder_reset(struct crowd_decoder *dec);
+int crowd_decoder_feed(struct crowd_decoder *dec, int level, uint64_t ts_ns,
+                       uint64_t unit_ns, uint32_t symbol, uint32_t *word);
+
+#endif /* CROWD_CODEC_H */
@@ -6,6 +6,10 @@
  * 하드웨어 연결:
  * GPIO 17 (송신측) ↔ GPIO 26 (수신측)
  * GND ↔ GND
+ * (선택) ACK 복귀선: ack_tx_pin (수신측) → ack_rx_pin (송신측)
+ * (선택) 병렬 버스: bus_tx_pins + bus_tx_strobe_pin → bus_rx_pins + bus_rx_strobe_pin
+ * (선택) 이중 빔 센서 쌍: beam_a_pin (바깥쪽), beam_b_pin (안쪽) → /dev/crowd_gpio2
+ * (선택) 다중 송신기 공유선: multidrop=1 node_id=N, 송신기 여러 대 → 풀업된 선 하나 → 수신기
  * 
  * 파일 구성:
  * 1. crowd_driver.c - 커널 드라이버
@@ -20,6 +24,7 @@
 
 #include <linux/init.h>
 #include <linux/module.h>
+#include <linux/moduleparam.h>
 #include <linux/kernel.h>
 #include <linux/fs.h>
 #include <linux/cdev.h>
@@ -27,20 +32,32 @@
 #include <linux/gpio.h>
 #include <linux/gpio/consumer.h>
 #include <linux/interrupt.h>
+#include <linux/irq.h>
 #include <linux/wait.h>
 #include <linux/mutex.h>
+#include <linux/spinlock.h>
 #include <linux/uaccess.h>
 #include <linux/ioctl.h>
 #include <linux/slab.h>
 #include <linux/string.h>
 #include <linux/delay.h>
 #include <linux/timer.h>
+#include <linux/ktime.h>
+#include <linux/kfifo.h>
 #include <linux/workqueue.h>
+#include <linux/hrtimer.h>
+#include <linux/list.h>
+#include <linux/poll.h>
+#include <linux/random.h>
+#include <net/genetlink.h>
+
+#include "crowd_codec.h"
 
 /* 시스템 상수 */
 #define DEVICE_NAME "crowd_gpio"
 #define CLASS_NAME "crowd_monitor"
-#define MAX_DEVICES 2
+#define MAX_DEVICES 3
+#define CROWD_BEAM_MINOR 2          /* 이중 빔 센서 쌍 채널 */
 
 /* GPIO 핀 번호 (BCM 기준) */
 #define GPIO_TX_PIN 17    /* 송신용 핀 */
@@ -56,22 +73,329 @@
 #define GPIO_IOCTL_GET_COUNT _IOR(GPIO_IOCTL_MAGIC, 2, int)
 #define GPIO_IOCTL_RESET_COUNT _IO(GPIO_IOCTL_MAGIC, 3)
 #define GPIO_IOCTL_SET_THRESHOLD _IOW(GPIO_IOCTL_MAGIC, 4, int)
+#define GPIO_IOCTL_SET_COALESCE _IOW(GPIO_IOCTL_MAGIC, 5, struct crowd_coalesce)
+#define GPIO_IOCTL_GET_COALESCE _IOR(GPIO_IOCTL_MAGIC, 6, struct crowd_coalesce)
+#define GPIO_IOCTL_SET_EVENT_TS _IOW(GPIO_IOCTL_MAGIC, 7, int)
+
+/* generic netlink 패밀리 (디바이스 fd 없이 인원/환기 변경을 구독) */
+#define CROWD_NL_FAMILY_NAME "crowd_monitor"
+#define CROWD_NL_FAMILY_VERSION 1
+#define CROWD_NL_MCGRP_NAME "events"
+
+enum crowd_nl_cmd {
+    CROWD_NL_CMD_UNSPEC,
+    CROWD_NL_CMD_GET,           /* 요청: CHANNEL 지정 시 한 채널, 덤프 시 전체 채널 */
+    CROWD_NL_CMD_CHANGE,        /* 멀티캐스트 알림: 인원/환기 변경 */
+    __CROWD_NL_CMD_MAX,
+};
+
+enum crowd_nl_attr {
+    CROWD_NL_ATTR_UNSPEC,
+    CROWD_NL_ATTR_PAD,
+    CROWD_NL_ATTR_CHANNEL,      /* u32: minor 번호 */
+    CROWD_NL_ATTR_ZONE,         /* u32: sysfs zone */
+    CROWD_NL_ATTR_DELTA,        /* s32: 이번 변경량 (GET 응답은 0) */
+    CROWD_NL_ATTR_OCCUPANCY,    /* u32: 변경 후 인원 */
+    CROWD_NL_ATTR_THRESHOLD,    /* u32 */
+    CROWD_NL_ATTR_VENTILATION,  /* u8: 1이면 환기 작동 */
+    CROWD_NL_ATTR_TIMESTAMP,    /* u64: CLOCK_REALTIME ns */
+    CROWD_NL_ATTR_MODE,         /* u32: MODE_TRANSMITTER / MODE_RECEIVER */
+    __CROWD_NL_ATTR_MAX,
+};
+#define CROWD_NL_ATTR_MAX (__CROWD_NL_ATTR_MAX - 1)
+
+/* 수신 깨우기 조절 (NIC 인터럽트 병합과 같은 방식)
+ * 대기 이벤트가 max_events개 쌓이거나 첫 대기 이벤트 후 max_usecs가 지나면 read를 깨움 */
+struct crowd_coalesce {
+    __u32 max_events;       /* 1: 이벤트마다 깨움 (기본) */
+    __u32 max_usecs;        /* 0: 시간 조건 없음 (max_events가 1일 때만 허용) */
+};
+
+/* 링크 프레임 형식과 선로 부호화는 crowd_codec.h */
+#define CROWD_TX_QUEUE_LEN CROWD_SEQ_SPACE
+#define CROWD_RESYNC_TIMEOUTS 8         /* 진전 없이 연속 타임아웃이면 SYNC로 수신측 기준점 재설정 */
+#define CROWD_BUS_MAX_WIDTH 8
+
+#define CROWD_EDGE_FIFO_SIZE 256
+#define CROWD_STORM_WINDOW_NS (10 * NSEC_PER_MSEC)   /* 에지율 측정 구간 */
+#define CROWD_STORM_BACKOFF_MAX_MS 5000
+#define CROWD_EVENT_FIFO_SIZE 256
+#define CROWD_COALESCE_MAX_EVENTS (CROWD_EVENT_FIFO_SIZE / 2)
+#define CROWD_EVENT_LINE_MAX 32         /* 가장 긴 이벤트 줄 "UNKNOWN <u64 ns>\n" */
+/* 최대 묶음이 read 한 번에 다 들어가도록 */
+#define CROWD_READ_BUF_SIZE (CROWD_COALESCE_MAX_EVENTS * CROWD_EVENT_LINE_MAX)
+#define CROWD_COALESCE_MAX_USECS 1000000
+
+/* 다중 송신기 공유선 */
+#define CROWD_MAX_NODES 32              /* 수신측이 구분하는 노드 ID 0~31 */
+#define CROWD_OD_SETTLE_US 5            /* 선을 놓은 뒤 풀업으로 HIGH가 될 때까지 */
+#define CROWD_LBT_IDLE_UNITS 4          /* 수신 디코더가 프레임을 버리는 3단위보다 길게 */
+#define CROWD_BACKOFF_SLOT_UNITS 8
+#define CROWD_BACKOFF_MAX_EXP 6         /* 최대 2^6 슬롯 */
+#define CROWD_TX_MAX_ATTEMPTS 10
+
+/* 모듈 파라미터 (gpio-sim 등 다른 칩에서 테스트할 때 핀 번호 변경) */
+static int tx_pin = GPIO_TX_PIN;
+module_param(tx_pin, int, 0444);
+MODULE_PARM_DESC(tx_pin, "송신 GPIO 번호 (기본 17)");
+
+static int rx_pin = GPIO_RX_PIN;
+module_param(rx_pin, int, 0444);
+MODULE_PARM_DESC(rx_pin, "수신 GPIO 번호 (기본 26)");
+
+static int ack_tx_pin = -1;
+module_param(ack_tx_pin, int, 0444);
+MODULE_PARM_DESC(ack_tx_pin, "수신측이 ACK를 내보내는 GPIO 번호 (-1: 사용 안 함)");
+
+static int ack_rx_pin = -1;
+module_param(ack_rx_pin, int, 0444);
+MODULE_PARM_DESC(ack_rx_pin, "송신측이 ACK를 받는 GPIO 번호 (-1: 사용 안 함)");
+
+static int bus_tx_pins[CROWD_BUS_MAX_WIDTH];
+static int bus_tx_width;
+module_param_array(bus_tx_pins, int, &bus_tx_width, 0444);
+MODULE_PARM_DESC(bus_tx_pins, "버스 모드 송신 데이터 GPIO 목록 (LSB부터, 1/2/3/4/6/8개)");
+
+static int bus_tx_strobe_pin = -1;
+module_param(bus_tx_strobe_pin, int, 0444);
+MODULE_PARM_DESC(bus_tx_strobe_pin, "버스 모드 송신 스트로브 GPIO (bus_tx_pins와 함께 사용)");
+
+static int bus_rx_pins[CROWD_BUS_MAX_WIDTH];
+static int bus_rx_width;
+module_param_array(bus_rx_pins, int, &bus_rx_width, 0444);
+MODULE_PARM_DESC(bus_rx_pins, "버스 모드 수신 데이터 GPIO 목록 (송신측과 같은 순서)");
+
+static int bus_rx_strobe_pin = -1;
+module_param(bus_rx_strobe_pin, int, 0444);
+MODULE_PARM_DESC(bus_rx_strobe_pin, "버스 모드 수신 스트로브 GPIO (bus_rx_pins와 함께 사용)");
+
+static int beam_a_pin = -1;
+module_param(beam_a_pin, int, 0444);
+MODULE_PARM_DESC(beam_a_pin, "센서 쌍 바깥쪽 빔 GPIO (A → B 통과 = 입장, -1: 사용 안 함)");
+
+static int beam_b_pin = -1;
+module_param(beam_b_pin, int, 0444);
+MODULE_PARM_DESC(beam_b_pin, "센서 쌍 안쪽 빔 GPIO (B → A 통과 = 퇴장)");
+
+static bool beam_active_low = true;
+module_param(beam_active_low, bool, 0444);
+MODULE_PARM_DESC(beam_active_low, "빔이 끊기면 LOW를 내는 센서 (기본 1)");
+
+static unsigned int beam_min_break_us = 10000;
+module_param(beam_min_break_us, uint, 0444);
+MODULE_PARM_DESC(beam_min_break_us, "이보다 짧은 차단은 잡음으로 무시 (us, 기본 10000, sysfs로 변경 가능)");
+
+static unsigned int beam_max_gap_ms = 1000;
+module_param(beam_max_gap_ms, uint, 0444);
+MODULE_PARM_DESC(beam_max_gap_ms, "첫 빔 차단 후 다른 빔이 끊겨야 하는 시간 (ms, 기본 1000)");
+
+static unsigned int beam_max_cross_ms = 3000;
+module_param(beam_max_cross_ms, uint, 0444);
+MODULE_PARM_DESC(beam_max_cross_ms, "첫 차단부터 두 빔 복구까지의 최대 통과 시간 (ms, 기본 3000)");
+
+static unsigned int bit_unit_us = 1000;
+module_param(bit_unit_us, uint, 0444);
+MODULE_PARM_DESC(bit_unit_us, "선로 부호화 기본 단위 (us, 기본 1000)");
+
+static unsigned int ack_timeout_ms = 500;
+module_param(ack_timeout_ms, uint, 0644);
+MODULE_PARM_DESC(ack_timeout_ms, "ACK 대기 후 재전송까지의 시간 (ms, 기본 500)");
+
+static unsigned int max_edge_rate = 10000;
+module_param(max_edge_rate, uint, 0444);
+MODULE_PARM_DESC(max_edge_rate, "라인별 최대 에지율 기본값 (edges/s, 초과 시 IRQ 마스크, 0: 제한 없음)");
+
+static unsigned int storm_backoff_ms = 100;
+module_param(storm_backoff_ms, uint, 0644);
+MODULE_PARM_DESC(storm_backoff_ms, "IRQ 폭주 시 첫 마스크 시간 (ms, 연속 폭주마다 2배)");
+
+static bool multidrop;
+module_param(multidrop, bool, 0444);
+MODULE_PARM_DESC(multidrop, "데이터선을 여러 송신기가 공유하는 오픈 드레인 선으로 사용 (풀업 필요, LOW = 펄스)");
+
+static unsigned int node_id;
+module_param(node_id, uint, 0444);
+MODULE_PARM_DESC(node_id, "송신 프레임에 싣는 노드 ID (0~31, 공유선의 송신기마다 달라야 함)");
+
+/* 하드 IRQ에서 기록한 에지 */
+struct crowd_edge {
+    u64 ts_ns;
+    int level;              /* -1: 슬립 가능한 칩이라 하드 IRQ에서 읽지 못함 */
+    int data;               /* 버스 모드 래치 값 (-1: 아직 읽지 않음) */
+};
+
+/* 병렬 버스 데이터 라인 묶음 (스트로브는 데이터선 crowd_line이 담당) */
+struct crowd_bus {
+    struct gpio_desc *desc[CROWD_BUS_MAX_WIDTH];
+    unsigned int width;         /* 0: 직렬 모드 */
+    bool can_sleep;
+};
+
+struct crowd_device;
+
+/* 에지를 수신하는 GPIO 라인 (데이터선, ACK 복귀선) */
+struct crowd_line {
+    struct crowd_device *owner;
+    struct gpio_desc *gpio_desc;
+    int irq_num;
+    bool irq_enabled;
+    bool irq_nested;                /* I2C/SPI 확장 칩 등: 하드 IRQ 없이 부모 스레드에서 호출됨 */
+    bool can_sleep;
+    int last_level;
+    struct crowd_bus *bus;          /* 버스 모드 스트로브 라인이면 데이터 라인 묶음 */
+    struct crowd_beam_pair *pair;   /* 센서 쌍의 빔이면 방향 판정기 (디코더 대신) */
+    bool open_drain;                /* 공유선: 액티브 LOW, 출력 LOW / 입력 전환으로 구동 */
+    DECLARE_KFIFO(edge_fifo, struct crowd_edge, CROWD_EDGE_FIFO_SIZE);
+    struct crowd_decoder decoder;
+    
+    /* IRQ 폭주 방지 (카운터는 하드 IRQ에서만 갱신) */
+    unsigned int max_edge_rate;
+    u64 rate_window_start;
+    unsigned int rate_window_edges;
+    bool storm_masked;
+    bool storm_resync;
+    unsigned int storm_backoff;     /* 현재 마스크 시간 (ms) */
+    u64 storm_unmasked_at;
+    unsigned long edges;
+    unsigned long storms;
+    struct delayed_work unmask_work;
+};
+
+/*
+ * 이중 빔 센서 쌍. 빔 A가 바깥쪽이며 A → B 순서로 끊기고 B가 마지막에 복구되면 입장,
+ * 반대면 퇴장이다. 한쪽만 끊거나 들어온 쪽으로 되돌아가면 되돌아감(bounce)으로 센다.
+ * 순서는 처리 순서가 아닌 하드 IRQ 타임스탬프로 판단한다.
+ */
+enum { CROWD_BEAM_A, CROWD_BEAM_B, CROWD_BEAM_COUNT };
+
+struct crowd_beam_pair {
+    struct crowd_line beam[CROWD_BEAM_COUNT];
+    spinlock_t lock;                /* 두 빔의 IRQ 스레드가 함께 갱신 */
+    int first;                      /* 이번 통과에서 먼저 끊긴 빔 (-1: 대기) */
+    u64 start_ns;
+    bool broken[CROWD_BEAM_COUNT];
+    bool seen[CROWD_BEAM_COUNT];    /* 이번 통과에서 min_break 이상 끊김 */
+    u64 break_ns[CROWD_BEAM_COUNT];
+    u64 clear_ns[CROWD_BEAM_COUNT];
+    
+    /* 판정 구간 (sysfs) */
+    unsigned int min_break_us;
+    unsigned int max_gap_ms;
+    unsigned int max_cross_ms;
+    
+    unsigned long enters;
+    unsigned long exits;
+    unsigned long bounces;
+    unsigned long timeouts;
+    unsigned long glitches;
+};
+
+/* 송신 큐 슬롯 (인덱스 = 시퀀스 번호) */
+struct crowd_tx_slot {
+    u8 type;
+    ktime_t sent_at;        /* 0이면 아직 전송 전 */
+    bool retransmitted;
+};
+
+/* 링크 통계 (sysfs link_stats) */
+struct crowd_link_stats {
+    unsigned long frames_sent;
+    unsigned long retransmits;
+    unsigned long timeouts;
+    unsigned long acks_sent;
+    unsigned long acks_received;
+    unsigned long frames_received;
+    unsigned long out_of_order;
+    unsigned long lost;
+    unsigned long crc_errors;
+    unsigned long framing_errors;
+    unsigned long edge_overruns;
+    unsigned long event_overruns;
+    unsigned long collisions;       /* 공유선 송신 중 다른 송신기 감지 */
+    unsigned long lbt_busy;         /* 송신 전 선이 사용 중 */
+    unsigned long backoffs;
+    unsigned long tx_aborts;        /* 재시도 한도 초과로 포기한 프레임 */
+    unsigned long unknown_node;     /* CROWD_MAX_NODES 밖의 노드 ID */
+    unsigned long resyncs;          /* 받은 SYNC 프레임 */
+    unsigned long resyncs_sent;     /* 연속 타임아웃으로 넣은 SYNC */
+    s64 rtt_last_us;
+    s64 rtt_min_us;
+    s64 rtt_max_us;
+    s64 rtt_avg_us;         /* EWMA (1/8) */
+};
+
+/* 송신 노드별 수신 상태 (nodes[] 인덱스 = 노드 ID) */
+struct crowd_node {
+    u8 rx_expected;
+    unsigned long frames;
+    unsigned long enters;
+    unsigned long exits;
+    unsigned long lost;
+    unsigned long out_of_order;
+    u64 first_ns;
+    u64 last_ns;
+};
 
 /* 디바이스 구조체 */
 struct crowd_device {
     struct device *dev;
     struct cdev cdev;
-    struct gpio_desc *gpio_desc;
+    struct crowd_line data_line;    /* 송신 시 출력, 수신 시 입력 */
+    struct crowd_line ack_line;     /* 송신 시 입력, 수신 시 출력 (선택) */
+    struct crowd_bus bus;           /* 버스 모드 데이터 라인 (선택) */
+    struct crowd_beam_pair *beams;  /* 센서 쌍 채널이면 두 빔 (선택) */
     int device_mode;
     int current_occupancy;
     int threshold;
     bool ventilation_active;
+    u32 zone;                       /* netlink 알림에 실리는 구역 번호 (sysfs) */
     struct mutex device_lock;
-    wait_queue_head_t read_wait;
-    struct work_struct irq_work;
-    int irq_num;
-    bool irq_enabled;
+    struct mutex config_lock;       /* 모드 전환 직렬화 (IRQ 해제는 device_lock 밖에서) */
     unsigned long total_messages;
+    
+    /* 수신 이벤트는 열린 파일마다 자기 큐로 복사 (read()로 전달) */
+    spinlock_t event_lock;
+    struct list_head readers;       /* 열린 파일 목록과 파일별 큐 (event_lock 보호) */
+    
+    /* 송신 큐 / 슬라이딩 윈도우 (tx_lock 보호) */
+    spinlock_t tx_lock;
+    struct crowd_tx_slot tx_ring[CROWD_TX_QUEUE_LEN];
+    u32 tx_base;            /* 가장 오래된 미확인 프레임 */
+    u32 tx_next;            /* 다음에 전송할 프레임 */
+    u32 tx_high;            /* 지금까지 전송한 최대 위치 + 1 */
+    u32 tx_head;            /* 다음에 큐잉할 위치 */
+    bool tx_sync;           /* 다음 프레임 앞에 SYNC를 넣음 (시작 / 송신 상태 초기화 후) */
+    unsigned int tx_stalls; /* ACK 진전 없이 연속된 재전송 타임아웃 */
+    unsigned int tx_window;
+    wait_queue_head_t tx_wait;
+    struct work_struct tx_work;
+    struct timer_list rtx_timer;
+    
+    /* 수신측 노드별 상태와 누적 ACK (ACK를 보낼 노드 비트맵) */
+    struct crowd_node nodes[CROWD_MAX_NODES];
+    DECLARE_BITMAP(ack_pending, CROWD_MAX_NODES);
+    struct work_struct ack_work;
+    
+    struct crowd_link_stats stats;
+};
+
+/* 수신 이벤트 (ts_ns: 프레임 마지막 에지의 하드 IRQ 시각, CLOCK_MONOTONIC) */
+struct crowd_event {
+    u8 type;
+    u64 ts_ns;
+};
+
+/* 열린 파일별 상태 (이벤트 큐도 파일마다 따로라서 읽는 쪽끼리 이벤트를 나눠 갖지 않음) */
+struct crowd_file {
+    struct crowd_device *dev;
+    struct list_head node;
+    DECLARE_KFIFO(event_fifo, struct crowd_event, CROWD_EVENT_FIFO_SIZE);
+    wait_queue_head_t wait;
+    struct hrtimer flush_timer;     /* 첫 대기 이벤트 후 max_usecs에 만료 */
+    unsigned int max_events;
+    unsigned int max_usecs;
+    bool flush;                     /* 타이머 만료: 쌓인 이벤트를 바로 전달 */
+    bool timestamps;                /* 줄마다 이벤트 시각(ns)을 붙임 (SET_EVENT_TS) */
 };
 
 /* 전역 변수 */
@@ -79,143 +403,1305 @@ static dev_t dev_num_base;
 static struct class *crowd_class;
 static struct crowd_device *devices[MAX_DEVICES];
 static int major_num;
+static struct workqueue_struct *crowd_wq;
+
+/* ========== generic netlink ========== */
+
+/* 알림/응답 한 건에 실리는 채널 상태 (device_lock 안에서 채움) */
+struct crowd_nl_state {
+    u32 channel;
+    u32 zone;
+    s32 delta;
+    u32 occupancy;
+    u32 threshold;
+    bool ventilation;
+    u32 mode;
+    u64 timestamp_ns;
+};
+
+static struct genl_family crowd_nl_family;
+
+static void crowd_nl_snapshot(struct crowd_device *dev, int delta, struct crowd_nl_state *st) {
+    st->channel = MINOR(dev->dev->devt);
+    st->zone = dev->zone;
+    st->delta = delta;
+    st->occupancy = dev->current_occupancy;
+    st->threshold = dev->threshold;
+    st->ventilation = dev->ventilation_active;
+    st->mode = dev->device_mode;
+    st->timestamp_ns = ktime_get_real_ns();
+}
+
+static int crowd_nl_fill(struct sk_buff *skb, const struct crowd_nl_state *st,
+                         u32 portid, u32 seq, int flags, u8 cmd) {
+    void *hdr = genlmsg_put(skb, portid, seq, &crowd_nl_family, flags, cmd);
+    
+    if (!hdr)
+        return -EMSGSIZE;
+    
+    if (nla_put_u32(skb, CROWD_NL_ATTR_CHANNEL, st->channel) ||
+        nla_put_u32(skb, CROWD_NL_ATTR_ZONE, st->zone) ||
+        nla_put_s32(skb, CROWD_NL_ATTR_DELTA, st->delta) ||
+        nla_put_u32(skb, CROWD_NL_ATTR_OCCUPANCY, st->occupancy) ||
+        nla_put_u32(skb, CROWD_NL_ATTR_THRESHOLD, st->threshold) ||
+        nla_put_u8(skb, CROWD_NL_ATTR_VENTILATION, st->ventilation) ||
+        nla_put_u32(skb, CROWD_NL_ATTR_MODE, st->mode) ||
+        nla_put_u64_64bit(skb, CROWD_NL_ATTR_TIMESTAMP, st->timestamp_ns, CROWD_NL_ATTR_PAD)) {
+        genlmsg_cancel(skb, hdr);
+        return -EMSGSIZE;
+    }
+    
+    genlmsg_end(skb, hdr);
+    return 0;
+}
+
+/* 변경 한 건을 한 번만 멀티캐스트 (구독자 수와 무관, 구독자가 없으면 생략) */
+static void crowd_nl_notify(const struct crowd_nl_state *st) {
+    struct sk_buff *skb;
+    
+    if (!genl_has_listeners(&crowd_nl_family, &init_net, 0))
+        return;
+    
+    skb = genlmsg_new(GENLMSG_DEFAULT_SIZE, GFP_KERNEL);
+    if (!skb)
+        return;
+    
+    if (crowd_nl_fill(skb, st, 0, 0, 0, CROWD_NL_CMD_CHANGE)) {
+        nlmsg_free(skb);
+        return;
+    }
+    
+    genlmsg_multicast(&crowd_nl_family, skb, 0, 0, GFP_KERNEL);
+}
+
+static void crowd_nl_read_state(struct crowd_device *dev, struct crowd_nl_state *st) {
+    mutex_lock(&dev->device_lock);
+    crowd_nl_snapshot(dev, 0, st);
+    mutex_unlock(&dev->device_lock);
+}
+
+static int crowd_nl_get_doit(struct sk_buff *skb, struct genl_info *info) {
+    struct crowd_nl_state st;
+    struct sk_buff *msg;
+    u32 channel;
+    int ret;
+    
+    if (GENL_REQ_ATTR_CHECK(info, CROWD_NL_ATTR_CHANNEL))
+        return -EINVAL;
+    
+    channel = nla_get_u32(info->attrs[CROWD_NL_ATTR_CHANNEL]);
+    if (channel >= MAX_DEVICES || !devices[channel])
+        return -ENODEV;
+    
+    crowd_nl_read_state(devices[channel], &st);
+    
+    msg = genlmsg_new(GENLMSG_DEFAULT_SIZE, GFP_KERNEL);
+    if (!msg)
+        return -ENOMEM;
+    
+    ret = crowd_nl_fill(msg, &st, info->snd_portid, info->snd_seq, 0, CROWD_NL_CMD_GET);
+    if (ret) {
+        nlmsg_free(msg);
+        return ret;
+    }
+    
+    return genlmsg_reply(msg, info);
+}
+
+/* 전체 채널 상태를 한 번의 덤프로 (cb->args[0]: 다음 채널) */
+static int crowd_nl_get_dumpit(struct sk_buff *skb, struct netlink_callback *cb) {
+    struct crowd_nl_state st;
+    int channel;
+    
+    for (channel = cb->args[0]; channel < MAX_DEVICES; channel++) {
+        if (!devices[channel])
+            continue;
+    
+        crowd_nl_read_state(devices[channel], &st);
+        if (crowd_nl_fill(skb, &st, NETLINK_CB(cb->skb).portid, cb->nlh->nlmsg_seq,
+                          NLM_F_MULTI, CROWD_NL_CMD_GET))
+            break;
+    }
+    
+    cb->args[0] = channel;
+    return skb->len;
+}
+
+static const struct nla_policy crowd_nl_policy[CROWD_NL_ATTR_MAX + 1] = {
+    [CROWD_NL_ATTR_CHANNEL] = { .type = NLA_U32 },
+};
+
+static const struct genl_small_ops crowd_nl_ops[] = {
+    {
+        .cmd = CROWD_NL_CMD_GET,
+        .doit = crowd_nl_get_doit,
+        .dumpit = crowd_nl_get_dumpit,
+    },
+};
+
+static const struct genl_multicast_group crowd_nl_mcgrps[] = {
+    { .name = CROWD_NL_MCGRP_NAME },
+};
+
+static struct genl_family crowd_nl_family = {
+    .name = CROWD_NL_FAMILY_NAME,
+    .version = CROWD_NL_FAMILY_VERSION,
+    .maxattr = CROWD_NL_ATTR_MAX,
+    .policy = crowd_nl_policy,
+    .module = THIS_MODULE,
+    .small_ops = crowd_nl_ops,
+    .n_small_ops = ARRAY_SIZE(crowd_nl_ops),
+    .mcgrps = crowd_nl_mcgrps,
+    .n_mcgrps = ARRAY_SIZE(crowd_nl_mcgrps),
+};
 
 /* ========== 헬퍼 함수들 ========== */
 
+/* 환기 상태를 인원/임계값에 맞춤 (device_lock 보유). 바뀌었으면 true */
+static bool crowd_update_ventilation(struct crowd_device *dev) {
+    bool should_ventilate = (dev->current_occupancy >= dev->threshold);
+    
+    if (should_ventilate == dev->ventilation_active)
+        return false;
+    
+    dev->ventilation_active = should_ventilate;
+    pr_info("[crowd_monitor] 환기 시스템 %s (인원: %d명, 임계값: %d명)\n",
+            should_ventilate ? "작동" : "중지",
+            dev->current_occupancy, dev->threshold);
+    return true;
+}
+
+/* 임계값 변경 (ioctl / sysfs 공통): 환기 상태도 같은 잠금 안에서 다시 판정 */
+static void crowd_set_threshold(struct crowd_device *dev, int value) {
+    struct crowd_nl_state st;
+    bool changed;
+    
+    mutex_lock(&dev->device_lock);
+    dev->threshold = value;
+    changed = crowd_update_ventilation(dev);
+    crowd_nl_snapshot(dev, 0, &st);
+    mutex_unlock(&dev->device_lock);
+    
+    if (changed)
+        crowd_nl_notify(&st);
+}
+
 /* 인원 카운터 업데이트 */
 static void update_occupancy(struct crowd_device *dev, int change) {
+    struct crowd_nl_state st;
+    int old_occupancy;
+    bool changed;
+    
     mutex_lock(&dev->device_lock);
     
+    old_occupancy = dev->current_occupancy;
     dev->current_occupancy += change;
     if (dev->current_occupancy < 0)
         dev->current_occupancy = 0;
+    changed = dev->current_occupancy != old_occupancy;
+    
+    /* 환기 시스템 제어 */
+    if (crowd_update_ventilation(dev))
+        changed = true;
+    
+    crowd_nl_snapshot(dev, dev->current_occupancy - old_occupancy, &st);
+    mutex_unlock(&dev->device_lock);
+    
+    if (changed)
+        crowd_nl_notify(&st);
+}
+
+static const char *frame_type_name(u8 type) {
+    switch (type) {
+    case CROWD_FRAME_ENTER: return "ENTER";
+    case CROWD_FRAME_EXIT: return "EXIT";
+    case CROWD_FRAME_STATUS: return "STATUS";
+    case CROWD_FRAME_ACK: return "ACK";
+    case CROWD_FRAME_SYNC: return "SYNC";
+    default: return "UNKNOWN";
+    }
+}
+
+/* ========== 링크 프레임 송신 ========== */
+
+static void crowd_delay_units(unsigned int units) {
+    unsigned long us = (unsigned long)units * bit_unit_us;
+    
+    usleep_range(us, us + us / 8 + 1);
+}
+
+static void crowd_line_pulse(struct gpio_desc *desc, unsigned int units) {
+    gpiod_set_value_cansleep(desc, 1);
+    crowd_delay_units(units);
+    gpiod_set_value_cansleep(desc, 0);
+    crowd_delay_units(1);
+}
+
+/*
+ * 프레임 하나를 펄스열로 내보냄 (슬립함, 라인당 한 컨텍스트에서만 호출).
+ * bus가 있으면 펄스마다 심볼을 데이터 라인에 먼저 올림 (프리앰블 제외).
+ */
+static void crowd_send_pulses(struct gpio_desc *desc, struct crowd_bus *bus,
+                              const struct crowd_frame *frame) {
+    struct crowd_pulse pulses[CROWD_MAX_PULSES];
+    DECLARE_BITMAP(values, CROWD_BUS_MAX_WIDTH);
+    int n, i;
+    
+    n = crowd_encode_word(crowd_frame_pack(frame), bus ? bus->width : 0, pulses);
+    for (i = 0; i < n; i++) {
+        if (bus && i > 0) {
+            values[0] = pulses[i].symbol;
+            gpiod_set_array_value_cansleep(bus->width, bus->desc, NULL, values);
+        }
+        crowd_line_pulse(desc, pulses[i].high_units);
+    }
+    crowd_delay_units(CROWD_IFG_UNITS);
+}
+
+static void crowd_line_send_frame(struct crowd_line *line, const struct crowd_frame *frame) {
+    crowd_send_pulses(line->gpio_desc, NULL, frame);
+}
+
+/* 버스 데이터 라인 값 래치 (스트로브 상승 직후) */
+static int crowd_bus_latch(struct crowd_bus *bus, bool cansleep) {
+    DECLARE_BITMAP(values, CROWD_BUS_MAX_WIDTH);
+    int ret;
+    
+    if (cansleep)
+        ret = gpiod_get_array_value_cansleep(bus->width, bus->desc, NULL, values);
+    else
+        ret = gpiod_get_array_value(bus->width, bus->desc, NULL, values);
+    
+    /* 읽기 실패는 0으로 두고 CRC에서 걸러지게 함 */
+    return ret < 0 ? 0 : (int)(values[0] & (BIT(bus->width) - 1));
+}
+
+/*
+ * 다중 송신기 공유선. 선은 풀업되어 있고 어느 송신기든 LOW로 끌어내리면 펄스(논리 1)다.
+ * gpio_to_desc로 얻은 디스크립터에는 오픈 드레인 플래그를 줄 수 없으므로
+ * gpiolib 에뮬레이션과 같이 출력 LOW(끌어내림) / 입력(놓음) 전환으로 구동한다.
+ */
+static void crowd_od_drive(struct gpio_desc *desc) {
+    gpiod_direction_output(desc, 1);
+}
+
+static void crowd_od_release(struct gpio_desc *desc) {
+    gpiod_direction_input(desc);
+}
+
+/* listen-before-talk: CROWD_LBT_IDLE_UNITS 동안 단위마다 읽어 한 번도 펄스가 없어야 함 */
+static bool crowd_od_idle(struct gpio_desc *desc) {
+    int i;
+    
+    for (i = 0; i < CROWD_LBT_IDLE_UNITS; i++) {
+        if (gpiod_get_value_cansleep(desc))
+            return false;
+        crowd_delay_units(1);
+    }
+    return !gpiod_get_value_cansleep(desc);
+}
+
+/*
+ * 공유선으로 프레임 송신 시도. 선을 놓은 직후와 다음 펄스 직전에 되읽어서
+ * 아직 LOW면 다른 송신기가 끌어내리는 중이므로 충돌로 보고 바로 멈춘다.
+ * 상대 펄스가 우리 펄스 안에 완전히 숨으면 우리 프레임은 온전하고 상대만 충돌을 본다.
+ */
+static int crowd_od_send_frame(struct gpio_desc *desc, const struct crowd_frame *frame) {
+    struct crowd_pulse pulses[CROWD_MAX_PULSES];
+    int n, i;
+    
+    n = crowd_encode_word(crowd_frame_pack(frame), 0, pulses);
+    for (i = 0; i < n; i++) {
+        crowd_od_drive(desc);
+        crowd_delay_units(pulses[i].high_units);
+        crowd_od_release(desc);
+    
+        udelay(CROWD_OD_SETTLE_US);
+        if (gpiod_get_value_cansleep(desc))
+            return -EAGAIN;
+        crowd_delay_units(1);
+        if (gpiod_get_value_cansleep(desc))
+            return -EAGAIN;
+    }
+    crowd_delay_units(CROWD_IFG_UNITS);
+    return 0;
+}
+
+/* 선이 비었을 때만 송신하고, 사용 중이거나 충돌하면 무작위 이진 지수 백오프 후 재시도 */
+static int crowd_od_send_data_frame(struct crowd_device *dev, const struct crowd_frame *frame) {
+    struct gpio_desc *desc = dev->data_line.gpio_desc;
+    unsigned int attempt;
+    u32 slots;
+    
+    for (attempt = 0; attempt < CROWD_TX_MAX_ATTEMPTS; attempt++) {
+        if (attempt) {
+            slots = get_random_u32_below(1U << min(attempt, (unsigned int)CROWD_BACKOFF_MAX_EXP));
+            dev->stats.backoffs++;
+            if (slots)
+                crowd_delay_units(slots * CROWD_BACKOFF_SLOT_UNITS);
+        }
+    
+        if (!crowd_od_idle(desc)) {
+            dev->stats.lbt_busy++;
+            continue;
+        }
+        if (crowd_od_send_frame(desc, frame) == 0)
+            return 0;
+    
+        dev->stats.collisions++;
+    }
+    
+    dev->stats.tx_aborts++;
+    return -EBUSY;
+}
+
+/* 버스 모드면 심볼을 데이터 라인에 올린 뒤 스트로브(데이터선) 펄스 */
+static int crowd_send_data_frame(struct crowd_device *dev, const struct crowd_frame *frame) {
+    if (dev->data_line.open_drain)
+        return crowd_od_send_data_frame(dev, frame);
+    
+    crowd_send_pulses(dev->data_line.gpio_desc, dev->bus.width ? &dev->bus : NULL, frame);
+    return 0;
+}
+
+/* ========== 송신 큐 / 슬라이딩 윈도우 ========== */
+
+static bool crowd_ack_enabled(struct crowd_device *dev) {
+    return dev->ack_line.gpio_desc != NULL;
+}
+
+static unsigned long crowd_ack_timeout(void) {
+    return msecs_to_jiffies(ack_timeout_ms ? ack_timeout_ms : 1);
+}
+
+static bool crowd_tx_has_room(struct crowd_device *dev) {
+    unsigned long flags;
+    bool room;
+    
+    spin_lock_irqsave(&dev->tx_lock, flags);
+    room = dev->tx_head - dev->tx_base < CROWD_TX_QUEUE_LEN;
+    spin_unlock_irqrestore(&dev->tx_lock, flags);
+    
+    return room;
+}
+
+static void crowd_rtt_sample(struct crowd_link_stats *stats, s64 rtt_us) {
+    stats->rtt_last_us = rtt_us;
+    if (!stats->rtt_min_us || rtt_us < stats->rtt_min_us)
+        stats->rtt_min_us = rtt_us;
+    if (rtt_us > stats->rtt_max_us)
+        stats->rtt_max_us = rtt_us;
+    
+    if (!stats->rtt_avg_us)
+        stats->rtt_avg_us = rtt_us;
+    else
+        stats->rtt_avg_us += (rtt_us - stats->rtt_avg_us) / 8;
+}
+
+/* 누적 ACK 처리: ack_seq = 수신측이 다음으로 기대하는 시퀀스 */
+static void crowd_tx_ack(struct crowd_device *dev, u8 ack_seq) {
+    struct crowd_tx_slot *last;
+    unsigned long flags;
+    u32 acked;
+    
+    spin_lock_irqsave(&dev->tx_lock, flags);
+    
+    acked = (ack_seq - dev->tx_base) & (CROWD_SEQ_SPACE - 1);
+    if (acked == 0 || acked > dev->tx_high - dev->tx_base) {
+        /* 중복 ACK 또는 범위 밖 */
+        spin_unlock_irqrestore(&dev->tx_lock, flags);
+        return;
+    }
+    
+    dev->stats.acks_received++;
+    dev->tx_stalls = 0;
+    
+    /* Karn 규칙: 재전송된 프레임으로는 RTT를 측정하지 않음 */
+    last = &dev->tx_ring[(dev->tx_base + acked - 1) % CROWD_TX_QUEUE_LEN];
+    if (!last->retransmitted && last->sent_at)
+        crowd_rtt_sample(&dev->stats, ktime_us_delta(ktime_get(), last->sent_at));
+    
+    dev->tx_base += acked;
+    if ((s32)(dev->tx_next - dev->tx_base) < 0)
+        dev->tx_next = dev->tx_base;
+    
+    if (dev->tx_base == dev->tx_high)
+        timer_delete(&dev->rtx_timer);
+    else
+        mod_timer(&dev->rtx_timer, jiffies + crowd_ack_timeout());
+    
+    spin_unlock_irqrestore(&dev->tx_lock, flags);
+    
+    wake_up_interruptible(&dev->tx_wait);
+    queue_work(crowd_wq, &dev->tx_work);
+}
+
+/*
+ * 미확인 프레임 앞 (이미 확인된 빈 자리)에 SYNC를 끼워 넣어 그 자리부터 다시 보냄 (tx_lock 보유).
+ * 수신측이 재적재 등으로 다른 시퀀스를 기대하고 있어도 SYNC 다음부터는 받아들임.
+ */
+static void crowd_tx_queue_resync(struct crowd_device *dev) {
+    struct crowd_tx_slot *slot = &dev->tx_ring[dev->tx_base % CROWD_TX_QUEUE_LEN];
+    
+    if (slot->type == CROWD_FRAME_SYNC || dev->tx_head - dev->tx_base >= CROWD_TX_QUEUE_LEN)
+        return;
+    
+    dev->tx_base--;
+    slot = &dev->tx_ring[dev->tx_base % CROWD_TX_QUEUE_LEN];
+    slot->type = CROWD_FRAME_SYNC;
+    slot->sent_at = 0;
+    slot->retransmitted = false;
+    
+    /* 비행 중 프레임 수가 시퀀스 공간을 넘지 않도록 SYNC부터 새로 전송한 것으로 셈 */
+    dev->tx_next = dev->tx_high = dev->tx_base;
+    dev->tx_stalls = 0;
+    dev->stats.resyncs_sent++;
+}
+
+/* 재전송 타이머: Go-Back-N 방식으로 윈도우 전체를 다시 보냄 */
+static void rtx_timer_handler(struct timer_list *t) {
+    struct crowd_device *dev = container_of(t, struct crowd_device, rtx_timer);
+    unsigned long flags;
+    
+    spin_lock_irqsave(&dev->tx_lock, flags);
+    if (dev->tx_base != dev->tx_high) {
+        dev->stats.timeouts++;
+        dev->tx_next = dev->tx_base;
+        if (++dev->tx_stalls >= CROWD_RESYNC_TIMEOUTS)
+            crowd_tx_queue_resync(dev);
+    }
+    spin_unlock_irqrestore(&dev->tx_lock, flags);
+    
+    queue_work(crowd_wq, &dev->tx_work);
+}
+
+/* 송신 워커: 윈도우가 허용하는 만큼 큐의 프레임을 연속 전송 */
+static void tx_work_handler(struct work_struct *work) {
+    struct crowd_device *dev = container_of(work, struct crowd_device, tx_work);
+    struct crowd_tx_slot *slot;
+    struct crowd_frame frame;
+    unsigned long flags;
+    bool ack = crowd_ack_enabled(dev);
+    int ret;
+    
+    for (;;) {
+        spin_lock_irqsave(&dev->tx_lock, flags);
+        /* SYNC가 확인되기 전에는 뒤 프레임을 보내지 않음 (재전송된 SYNC가 받은 프레임을 되돌리지 않도록) */
+        if (dev->tx_next == dev->tx_head ||
+            (ack && dev->tx_next - dev->tx_base >= dev->tx_window) ||
+            (ack && dev->tx_next != dev->tx_base &&
+             dev->tx_ring[dev->tx_base % CROWD_TX_QUEUE_LEN].type == CROWD_FRAME_SYNC)) {
+            spin_unlock_irqrestore(&dev->tx_lock, flags);
+            break;
+        }
+    
+        slot = &dev->tx_ring[dev->tx_next % CROWD_TX_QUEUE_LEN];
+        frame.type = slot->type;
+        frame.seq = dev->tx_next % CROWD_SEQ_SPACE;
+        frame.node = node_id;
+    
+        if (slot->sent_at) {
+            slot->retransmitted = true;
+            dev->stats.retransmits++;
+        }
+        slot->sent_at = ktime_get();
+    
+        dev->tx_next++;
+        if ((s32)(dev->tx_next - dev->tx_high) > 0)
+            dev->tx_high = dev->tx_next;
+    
+        if (ack && !timer_pending(&dev->rtx_timer))
+            mod_timer(&dev->rtx_timer, jiffies + crowd_ack_timeout());
+        spin_unlock_irqrestore(&dev->tx_lock, flags);
+    
+        ret = crowd_send_data_frame(dev, &frame);
+    
+        spin_lock_irqsave(&dev->tx_lock, flags);
+        if (ret == 0)
+            dev->stats.frames_sent++;
+        if (!ack) {
+            /* ACK 복귀선이 없으면 전송 즉시 완료 처리 (공유선에서 포기한 프레임은 손실) */
+            dev->tx_base = dev->tx_next;
+        }
+        spin_unlock_irqrestore(&dev->tx_lock, flags);
+    
+        if (!ack)
+            wake_up_interruptible(&dev->tx_wait);
+    }
+}
+
+/*
+ * 송신 상태 초기화. 재전송 타이머가 워커를 다시 큐에 넣고 워커가 타이머를 다시 걸 수 있으므로
+ * 타이머 → 워커 → 타이머 순서로 멈춤. shutdown이면 (디바이스 해제 직전) 타이머를 다시 걸 수 없게 함.
+ */
+static void crowd_tx_reset(struct crowd_device *dev, bool shutdown) {
+    unsigned long flags;
+    
+    if (shutdown)
+        timer_shutdown_sync(&dev->rtx_timer);
+    else
+        timer_delete_sync(&dev->rtx_timer);
+    cancel_work_sync(&dev->tx_work);
+    timer_delete_sync(&dev->rtx_timer);
+    
+    spin_lock_irqsave(&dev->tx_lock, flags);
+    dev->tx_base = dev->tx_next = dev->tx_high = dev->tx_head = 0;
+    dev->tx_sync = true;
+    dev->tx_stalls = 0;
+    spin_unlock_irqrestore(&dev->tx_lock, flags);
+    
+    wake_up_interruptible(&dev->tx_wait);
+}
+
+/* GPIO 신호 전송: 프레임을 송신 큐에 넣고 워커가 전송 */
+static int send_signal(struct crowd_device *dev, int signal_type, bool nonblock) {
+    struct crowd_tx_slot *slot;
+    unsigned long flags;
+    
+    if (!dev->data_line.gpio_desc || dev->device_mode != MODE_TRANSMITTER) {
+        return -EINVAL;
+    }
+    
+    if (signal_type < CROWD_FRAME_ENTER || signal_type > CROWD_FRAME_STATUS) {
+        return -EINVAL;
+    }
+    
+    for (;;) {
+        spin_lock_irqsave(&dev->tx_lock, flags);
+        if (dev->tx_head - dev->tx_base < CROWD_TX_QUEUE_LEN) {
+            /* tx_sync는 큐가 빈 상태에서만 켜지므로 SYNC 자리는 항상 있음 */
+            if (dev->tx_sync) {
+                slot = &dev->tx_ring[dev->tx_head % CROWD_TX_QUEUE_LEN];
+                slot->type = CROWD_FRAME_SYNC;
+                slot->sent_at = 0;
+                slot->retransmitted = false;
+                dev->tx_head++;
+                dev->tx_sync = false;
+            }
+            slot = &dev->tx_ring[dev->tx_head % CROWD_TX_QUEUE_LEN];
+            slot->type = signal_type;
+            slot->sent_at = 0;
+            slot->retransmitted = false;
+            dev->tx_head++;
+            spin_unlock_irqrestore(&dev->tx_lock, flags);
+            break;
+        }
+        spin_unlock_irqrestore(&dev->tx_lock, flags);
+    
+        if (nonblock) {
+            return -EAGAIN;
+        }
+        if (wait_event_interruptible(dev->tx_wait, crowd_tx_has_room(dev))) {
+            return -ERESTARTSYS;
+        }
+    }
+    
+    queue_work(crowd_wq, &dev->tx_work);
+    return 0;
+}
+
+/* ========== 수신 처리 ========== */
+
+/*
+ * 수신측 ACK 워커: ACK 대기 노드마다 최신 누적 ACK를 복귀선으로 전송
+ * (노드별 대기 요청은 하나로 합쳐짐, 복귀선은 모든 송신기가 듣고 자기 노드 ID만 받음)
+ */
+static void ack_work_handler(struct work_struct *work) {
+    struct crowd_device *dev = container_of(work, struct crowd_device, ack_work);
+    struct crowd_frame frame = { .type = CROWD_FRAME_ACK };
+    unsigned int n;
+    
+    for (n = 0; n < CROWD_MAX_NODES; n++) {
+        if (!test_and_clear_bit(n, dev->ack_pending))
+            continue;
+    
+        frame.seq = READ_ONCE(dev->nodes[n].rx_expected);
+        frame.node = n;
+        crowd_line_send_frame(&dev->ack_line, &frame);
+        dev->stats.acks_sent++;
+    }
+}
+
+/* 깨우기 조건: max_events개가 쌓였거나 병합 타이머가 만료됨 */
+static bool crowd_file_ready(struct crowd_file *cf) {
+    return kfifo_len(&cf->event_fifo) >= READ_ONCE(cf->max_events) ||
+           (READ_ONCE(cf->flush) && !kfifo_is_empty(&cf->event_fifo));
+}
+
+static enum hrtimer_restart crowd_flush_timer_handler(struct hrtimer *timer) {
+    struct crowd_file *cf = container_of(timer, struct crowd_file, flush_timer);
+    unsigned long flags;
+    
+    /*
+     * event_lock 안에서만 flush를 켬: read가 큐를 비우며 취소하려 할 때 이미 실행 중이었다면
+     * 빈 큐에 flush가 남아 다음 이벤트가 타이머도 깨우기도 없이 쌓이는 일이 없도록
+     */
+    spin_lock_irqsave(&cf->dev->event_lock, flags);
+    if (!kfifo_is_empty(&cf->event_fifo))
+        cf->flush = true;
+    spin_unlock_irqrestore(&cf->dev->event_lock, flags);
+    
+    wake_up_interruptible(&cf->wait);
+    return HRTIMER_NORESTART;
+}
+
+static void crowd_deliver_event(struct crowd_device *dev, u8 type, u64 ts_ns) {
+    struct crowd_event event = { .type = type, .ts_ns = ts_ns };
+    struct crowd_file *cf;
+    unsigned long flags;
+    unsigned int pending;
+    
+    dev->total_messages++;
+    /* 이벤트마다 printk하면 IRQ 스레드 비용을 좌우하므로 디버그 빌드/dynamic debug에서만 */
+    pr_debug("[crowd_monitor] 신호 수신: %s\n", frame_type_name(type));
+        
+    if (type == CROWD_FRAME_ENTER)
+        update_occupancy(dev, 1);
+    else if (type == CROWD_FRAME_EXIT)
+        update_occupancy(dev, -1);
+    
+    spin_lock_irqsave(&dev->event_lock, flags);
+    
+    /* 파일마다 큐에 넣고, 조건에 맞는 read 프로세스만 깨우고 나머지는 병합 타이머로 미룸 */
+    list_for_each_entry(cf, &dev->readers, node) {
+        if (!kfifo_put(&cf->event_fifo, event))
+            dev->stats.event_overruns++;
+        pending = kfifo_len(&cf->event_fifo);
+    
+        /* flush가 켜져 있으면 이미 기한이 지난 묶음 */
+        if (pending >= cf->max_events || cf->flush) {
+            wake_up_interruptible(&cf->wait);
+        } else if (cf->max_usecs && !cf->flush && !hrtimer_active(&cf->flush_timer)) {
+            hrtimer_start(&cf->flush_timer, us_to_ktime(cf->max_usecs), HRTIMER_MODE_REL);
+        }
+    }
+    spin_unlock_irqrestore(&dev->event_lock, flags);
+}
+
+/* 데이터선으로 들어온 프레임 (시퀀스와 ACK는 송신 노드별로 따로 관리) */
+static void crowd_rx_data_frame(struct crowd_device *dev, const struct crowd_frame *frame,
+                                u64 ts_ns) {
+    struct crowd_node *node;
+    unsigned long lost;
+    u8 expected;
+    
+    if ((frame->type < CROWD_FRAME_ENTER || frame->type > CROWD_FRAME_STATUS) &&
+        frame->type != CROWD_FRAME_SYNC)
+        return;
+    
+    if (frame->node >= CROWD_MAX_NODES) {
+        dev->stats.unknown_node++;
+        return;
+    }
+    node = &dev->nodes[frame->node];
+    expected = node->rx_expected;
+    
+    dev->stats.frames_received++;
+    node->last_ns = ktime_get_ns();
+    if (!node->frames++)
+        node->first_ns = node->last_ns;
+    
+    /*
+     * 송신기가 재시작했거나 모드를 바꿔 시퀀스 0부터 다시 보냄: 기대값을 SYNC 다음으로 맞춤.
+     * 송신측은 SYNC가 확인될 때까지 다음 프레임을 보내지 않으므로 중복 SYNC는 같은 값을 다시 쓸 뿐.
+     */
+    if (frame->type == CROWD_FRAME_SYNC) {
+        WRITE_ONCE(node->rx_expected, (frame->seq + 1) % CROWD_SEQ_SPACE);
+        dev->stats.resyncs++;
+        if (crowd_ack_enabled(dev)) {
+            set_bit(frame->node, dev->ack_pending);
+            queue_work(crowd_wq, &dev->ack_work);
+        }
+        return;
+    }
+    
+    if (crowd_ack_enabled(dev)) {
+        /*
+         * Go-Back-N: 순서대로 온 프레임만 받고, 항상 누적 ACK 응답.
+         * 노드의 첫 프레임은 (수신 모듈 재적재 후라도) 기준점으로 받아 송신측과 어긋난 채 남지 않게 함
+         */
+        bool in_order = frame->seq == expected || node->frames == 1;
+    
+        if (in_order) {
+            WRITE_ONCE(node->rx_expected, (frame->seq + 1) % CROWD_SEQ_SPACE);
+        } else {
+            dev->stats.out_of_order++;
+            node->out_of_order++;
+        }
+    
+        set_bit(frame->node, dev->ack_pending);
+        queue_work(crowd_wq, &dev->ack_work);
+        if (!in_order)
+            return;
+    } else {
+        /* 재전송이 없으므로 시퀀스 공백은 손실로만 집계 (노드의 첫 프레임은 기준점) */
+        lost = node->frames > 1 ? (frame->seq - expected) & (CROWD_SEQ_SPACE - 1) : 0;
+        dev->stats.lost += lost;
+        node->lost += lost;
+        WRITE_ONCE(node->rx_expected, (frame->seq + 1) % CROWD_SEQ_SPACE);
+    }
+    
+    if (frame->type == CROWD_FRAME_ENTER)
+        node->enters++;
+    else if (frame->type == CROWD_FRAME_EXIT)
+        node->exits++;
+    
+    crowd_deliver_event(dev, frame->type, ts_ns);
+}
+
+static void crowd_line_frame(struct crowd_line *line, u32 word, u64 ts_ns) {
+    struct crowd_device *dev = line->owner;
+    struct crowd_frame frame;
+    
+    if (crowd_frame_unpack(word, &frame)) {
+        dev->stats.crc_errors++;
+        return;
+    }
+    
+    if (line == &dev->ack_line) {
+        if (frame.type == CROWD_FRAME_ACK && frame.node == node_id &&
+            dev->device_mode == MODE_TRANSMITTER)
+            crowd_tx_ack(dev, frame.seq);
+    } else if (dev->device_mode == MODE_RECEIVER) {
+        crowd_rx_data_frame(dev, &frame, ts_ns);
+    }
+}
+
+/* ========== 이중 빔 센서 쌍 ========== */
+
+static void crowd_beam_reset(struct crowd_beam_pair *pair) {
+    pair->first = -1;
+    pair->seen[CROWD_BEAM_A] = false;
+    pair->seen[CROWD_BEAM_B] = false;
+}
+
+/*
+ * 빔 하나의 상태 변화 (pair->lock 보유). 두 빔이 모두 복구되어 통과가 끝나면
+ * 방향에 따라 CROWD_FRAME_ENTER/EXIT를, 그 외에는 0을 반환한다.
+ */
+static u8 crowd_beam_edge(struct crowd_beam_pair *pair, int idx, bool broken, u64 ts) {
+    u64 min_break = (u64)READ_ONCE(pair->min_break_us) * NSEC_PER_USEC;
+    u64 max_gap = (u64)READ_ONCE(pair->max_gap_ms) * NSEC_PER_MSEC;
+    u64 max_cross = (u64)READ_ONCE(pair->max_cross_ms) * NSEC_PER_MSEC;
+    int other = !idx;
+    int first, second, last;
+    u8 type = 0;
+    
+    if (broken == pair->broken[idx])
+        return 0;
+    pair->broken[idx] = broken;
+    
+    if (broken) {
+        pair->break_ns[idx] = ts;
+    
+        /* 끝나지 않은 채 너무 오래된 통과는 버림 */
+        if (pair->first >= 0 && (s64)(ts - pair->start_ns) > (s64)max_cross) {
+            pair->timeouts++;
+            crowd_beam_reset(pair);
+        }
+    
+        /* 다른 빔의 IRQ 스레드가 늦게 돌았어도 타임스탬프가 앞선 빔이 먼저 */
+        if (pair->first < 0 ||
+            (pair->first == other && !pair->seen[idx] && (s64)(ts - pair->start_ns) < 0)) {
+            pair->first = idx;
+            pair->start_ns = ts;
+        }
+        return 0;
+    }
+    
+    pair->clear_ns[idx] = ts;
+    
+    /* 통과 판정 중이 아니면 (로드 시 이미 끊겨 있던 빔 등) 무시 */
+    if (pair->first < 0)
+        return 0;
+    
+    if (ts - pair->break_ns[idx] < min_break) {
+        /* 잡음: 먼저 끊긴 빔이었다면 다른 빔을 기준으로 다시 */
+        pair->glitches++;
+        if (pair->first == idx && !pair->seen[idx]) {
+            if (pair->broken[other] || pair->seen[other]) {
+                pair->first = other;
+                pair->start_ns = pair->break_ns[other];
+            } else {
+                crowd_beam_reset(pair);
+            }
+        }
+    } else {
+        pair->seen[idx] = true;
+    }
+    
+    if (pair->first < 0 || pair->broken[CROWD_BEAM_A] || pair->broken[CROWD_BEAM_B])
+        return 0;
+    
+    /* 두 빔 모두 복구: 통과 판정 */
+    first = pair->first;
+    second = !first;
+    last = (s64)(pair->clear_ns[CROWD_BEAM_A] - pair->clear_ns[CROWD_BEAM_B]) > 0 ?
+           CROWD_BEAM_A : CROWD_BEAM_B;
+    
+    if (!pair->seen[first] || !pair->seen[second] || last != second) {
+        pair->bounces++;
+    } else if (pair->break_ns[second] - pair->break_ns[first] > max_gap ||
+               ts - pair->start_ns > max_cross) {
+        pair->timeouts++;
+    } else if (first == CROWD_BEAM_A) {
+        pair->enters++;
+        type = CROWD_FRAME_ENTER;
+    } else {
+        pair->exits++;
+        type = CROWD_FRAME_EXIT;
+    }
+    
+    crowd_beam_reset(pair);
+    return type;
+}
+
+static void crowd_beam_feed(struct crowd_line *line, int level, u64 ts) {
+    struct crowd_beam_pair *pair = line->pair;
+    u8 type;
+    
+    spin_lock(&pair->lock);
+    type = crowd_beam_edge(pair, line - pair->beam, level, ts);
+    spin_unlock(&pair->lock);
+    
+    /* 방향이 정해지면 사용자 공간을 거치지 않고 바로 인원 반영 */
+    if (type)
+        crowd_deliver_event(line->owner, type, ts);
+}
+
+static irqreturn_t crowd_beam_irq_thread(struct crowd_line *line) {
+    bool resync = READ_ONCE(line->storm_resync);
+    struct crowd_edge edge;
+    
+    if (resync)
+        WRITE_ONCE(line->storm_resync, false);
+    
+    while (kfifo_get(&line->edge_fifo, &edge)) {
+        if (edge.level < 0)
+            edge.level = !line->last_level;
+        line->last_level = edge.level;
+        crowd_beam_feed(line, edge.level, edge.ts_ns);
+    }
+    
+    /* 에지를 놓쳤을 수 있으면 (슬립 가능한 칩, 폭주 마스크 해제) 실제 레벨로 보정 */
+    if (line->can_sleep || resync) {
+        int level = gpiod_get_value_cansleep(line->gpio_desc);
+    
+        if (kfifo_is_empty(&line->edge_fifo) && level != line->last_level) {
+            line->last_level = level;
+            crowd_beam_feed(line, level, ktime_get_ns());
+        }
+    }
+    
+    return IRQ_HANDLED;
+}
+
+/* 인터럽트 스레드: 기록된 에지를 순서대로 디코딩 */
+static irqreturn_t gpio_irq_thread(int irq, void *dev_id) {
+    struct crowd_line *line = (struct crowd_line *)dev_id;
+    u64 unit_ns = (u64)bit_unit_us * NSEC_PER_USEC;
+    struct crowd_edge edge;
+    u32 word;
+    int ret;
+    
+    if (line->pair)
+        return crowd_beam_irq_thread(line);
+    
+    /* 마스크 해제 직후: 마스크 동안 놓친 에지 때문에 처음부터 다시 동기화 */
+    if (READ_ONCE(line->storm_resync)) {
+        WRITE_ONCE(line->storm_resync, false);
+        crowd_decoder_reset(&line->decoder);
+    }
+    
+    while (kfifo_get(&line->edge_fifo, &edge)) {
+        /* 레벨을 읽지 못한 에지는 직전 레벨의 반전으로 추정 */
+        if (edge.level < 0)
+            edge.level = !line->last_level;
+        line->last_level = edge.level;
+    
+        /* 하드 IRQ에서 래치하지 못했으면 여기서 읽음 (슬립 가능한 칩) */
+        if (line->bus && edge.level && edge.data < 0)
+            edge.data = crowd_bus_latch(line->bus, true);
+    
+        ret = crowd_decoder_feed(&line->decoder, edge.level, edge.ts_ns, unit_ns,
+                                 edge.data < 0 ? 0 : edge.data, &word);
+        if (ret > 0)
+            crowd_line_frame(line, word, edge.ts_ns);
+        else if (ret < 0)
+            line->owner->stats.framing_errors++;
+    }
+    
+    /* 추정 레벨이 실제와 어긋났으면 (에지 유실) 디코더 재동기화 */
+    if (line->can_sleep) {
+        int level = gpiod_get_value_cansleep(line->gpio_desc);
+    
+        if (kfifo_is_empty(&line->edge_fifo) && level != line->last_level) {
+            line->last_level = level;
+            crowd_decoder_reset(&line->decoder);
+        }
+    }
+    
+    return IRQ_HANDLED;
+}
+
+/* 폭주로 마스크한 IRQ를 백오프 후 다시 허용 */
+static void storm_unmask_handler(struct work_struct *work) {
+    struct crowd_line *line = container_of(to_delayed_work(work), struct crowd_line, unmask_work);
+    
+    line->storm_unmasked_at = ktime_get_ns();
+    WRITE_ONCE(line->storm_resync, true);
+    WRITE_ONCE(line->storm_masked, false);
+    enable_irq(line->irq_num);
+}
+
+/*
+ * 측정 구간 안의 에지 수가 한도를 넘으면 IRQ를 마스크하고 백오프한다.
+ * 해제 후 1초 안에 다시 폭주하면 마스크 시간을 2배로 늘린다.
+ */
+static bool crowd_line_storm_check(struct crowd_line *line, u64 now) {
+    unsigned int rate = READ_ONCE(line->max_edge_rate);
+    unsigned int limit;
+    
+    if (!rate)
+        return false;
+    
+    if (now - line->rate_window_start > CROWD_STORM_WINDOW_NS) {
+        line->rate_window_start = now;
+        line->rate_window_edges = 0;
+    }
+    
+    limit = max(1U, rate / (unsigned int)(NSEC_PER_SEC / CROWD_STORM_WINDOW_NS));
+    if (++line->rate_window_edges <= limit)
+        return false;
+    
+    if (line->storm_backoff && now - line->storm_unmasked_at < NSEC_PER_SEC)
+        line->storm_backoff = min(line->storm_backoff * 2, (unsigned int)CROWD_STORM_BACKOFF_MAX_MS);
+    else
+        line->storm_backoff = max(storm_backoff_ms, 1U);
+    
+    line->storms++;
+    line->storm_masked = true;
+    disable_irq_nosync(line->irq_num);
+    schedule_delayed_work(&line->unmask_work, msecs_to_jiffies(line->storm_backoff));
+    
+    pr_warn_ratelimited("[crowd_monitor] IRQ %d 폭주 감지 - %u ms 동안 마스크\n",
+                        line->irq_num, line->storm_backoff);
+    return true;
+}
+
+/* 에지 시각과 레벨만 기록. 스레드에서 디코딩할 에지가 있으면 true */
+static bool crowd_line_record_edge(struct crowd_line *line) {
+    struct crowd_edge edge = {
+        .ts_ns = ktime_get_ns(),
+        .level = line->can_sleep ? -1 : gpiod_get_value(line->gpio_desc),
+        .data = -1,
+    };
+    
+    /* 버스 모드: 스트로브 상승 에지에서 데이터 라인 래치 */
+    if (line->bus && edge.level == 1 && !line->bus->can_sleep)
+        edge.data = crowd_bus_latch(line->bus, false);
+    
+    line->edges++;
+    if (crowd_line_storm_check(line, edge.ts_ns))
+        return false;
+    
+    if (!kfifo_put(&line->edge_fifo, edge))
+        line->owner->stats.edge_overruns++;
+    
+    return true;
+}
+
+/* 하드 IRQ 핸들러: 에지를 기록하고 스레드로 넘김 */
+static irqreturn_t gpio_interrupt_handler(int irq, void *dev_id) {
+    return crowd_line_record_edge(dev_id) ? IRQ_WAKE_THREAD : IRQ_HANDLED;
+}
+
+/*
+ * 중첩 IRQ (부모 칩의 IRQ 스레드에서 호출): 하드 핸들러가 불리지 않으므로 여기서 시각을 찍고 바로 디코딩.
+ * 시각에 부모 칩의 상태 읽기 지연이 섞이므로 bit_unit_us를 넉넉히 잡아야 함.
+ */
+static irqreturn_t gpio_nested_irq_thread(int irq, void *dev_id) {
+    if (!crowd_line_record_edge(dev_id))
+        return IRQ_HANDLED;
+    
+    return gpio_irq_thread(irq, dev_id);
+}
+
+/* ========== GPIO 라인 관리 ========== */
+
+static int crowd_line_init(struct crowd_device *dev, struct crowd_line *line, int gpio_pin) {
+    line->owner = dev;
+    INIT_KFIFO(line->edge_fifo);
+    INIT_DELAYED_WORK(&line->unmask_work, storm_unmask_handler);
+    crowd_decoder_reset(&line->decoder);
+    line->max_edge_rate = max_edge_rate;
+    
+    if (gpio_pin < 0)
+        return 0;
+    
+    line->gpio_desc = gpio_to_desc(gpio_pin);
+    if (!line->gpio_desc) {
+        pr_err("[crowd_monitor] GPIO %d 획득 실패\n", gpio_pin);
+        return -ENODEV;
+    }
+    line->can_sleep = gpiod_cansleep(line->gpio_desc);
+    
+    /* 인터럽트 번호 획득 */
+    line->irq_num = gpiod_to_irq(line->gpio_desc);
+    if (line->irq_num < 0) {
+        pr_warn("[crowd_monitor] GPIO %d 인터럽트 번호 획득 실패\n", gpio_pin);
+        line->irq_num = 0;
+    }
+    
+    return 0;
+}
+
+static int crowd_bus_init(struct crowd_device *dev, const int *pins, int count) {
+    struct crowd_bus *bus = &dev->bus;
+    int i;
+    
+    if (count == 0)
+        return 0;
+    
+    if (count > CROWD_BUS_MAX_WIDTH || CROWD_FRAME_BITS % count) {
+        pr_err("[crowd_monitor] 지원하지 않는 버스 폭: %d (1/2/3/4/6/8)\n", count);
+        return -EINVAL;
+    }
+    if (!dev->data_line.gpio_desc) {
+        pr_err("[crowd_monitor] 버스 모드에는 스트로브 GPIO가 필요합니다\n");
+        return -EINVAL;
+    }
     
-    /* 환기 시스템 제어 */
-    bool should_ventilate = (dev->current_occupancy >= dev->threshold);
-    if (should_ventilate != dev->ventilation_active) {
-        dev->ventilation_active = should_ventilate;
-        pr_info("[crowd_monitor] 환기 시스템 %s (인원: %d명, 임계값: %d명)\n",
-                should_ventilate ? "작동" : "중지", 
-                dev->current_occupancy, dev->threshold);
+    for (i = 0; i < count; i++) {
+        bus->desc[i] = gpio_to_desc(pins[i]);
+        if (!bus->desc[i]) {
+            pr_err("[crowd_monitor] 버스 GPIO %d 획득 실패\n", pins[i]);
+            return -ENODEV;
+        }
+        if (gpiod_cansleep(bus->desc[i]))
+            bus->can_sleep = true;
     }
     
-    mutex_unlock(&dev->device_lock);
+    bus->width = count;
+    dev->data_line.bus = bus;
+    dev->data_line.decoder.symbol_bits = count;
+    return 0;
 }
 
-/* GPIO 신호 전송 (간단한 디지털 신호) */
-static int send_signal(struct crowd_device *dev, int signal_type) {
-    if (!dev->gpio_desc || dev->device_mode != MODE_TRANSMITTER) {
-        return -EINVAL;
+static void crowd_bus_set_direction(struct crowd_bus *bus, bool output) {
+    unsigned int i;
+    
+    for (i = 0; i < bus->width; i++) {
+        if (output)
+            gpiod_direction_output(bus->desc[i], 0);
+        else
+            gpiod_direction_input(bus->desc[i]);
     }
+}
+
+/* 라인을 입력으로 두고 양쪽 에지 인터럽트 활성화 */
+static int crowd_line_set_input(struct crowd_line *line, const char *irq_name) {
+    int ret;
     
-    /* 신호 타입에 따른 펄스 패턴 전송 */
-    switch (signal_type) {
-    case 1: /* ENTER - 짧은 펄스 1개 */
-        gpiod_set_value(dev->gpio_desc, 1);
-        msleep(100);
-        gpiod_set_value(dev->gpio_desc, 0);
-        msleep(100);
-        break;
-        
-    case 2: /* EXIT - 짧은 펄스 2개 */
-        gpiod_set_value(dev->gpio_desc, 1);
-        msleep(100);
-        gpiod_set_value(dev->gpio_desc, 0);
-        msleep(100);
-        gpiod_set_value(dev->gpio_desc, 1);
-        msleep(100);
-        gpiod_set_value(dev->gpio_desc, 0);
-        msleep(100);
-        break;
-        
-    case 3: /* STATUS - 긴 펄스 1개 */
-        gpiod_set_value(dev->gpio_desc, 1);
-        msleep(300);
-        gpiod_set_value(dev->gpio_desc, 0);
-        msleep(100);
-        break;
-        
-    default:
-        return -EINVAL;
+    if (!line->gpio_desc)
+        return 0;
+    
+    gpiod_direction_input(line->gpio_desc);
+    line->last_level = gpiod_get_value_cansleep(line->gpio_desc);
+    crowd_decoder_reset(&line->decoder);
+    
+    if (line->irq_enabled || line->irq_num <= 0)
+        return 0;
+    
+    /*
+     * 중첩 IRQ면 커널이 주 핸들러를 irq_nested_primary_handler로 바꿔 gpio_interrupt_handler가
+     * 불리지 않으므로, 스레드 함수 안에서 에지를 기록하는 쪽으로 등록
+     */
+    line->irq_nested = irq_check_status_bit(line->irq_num, IRQ_NESTED_THREAD);
+    if (line->irq_nested) {
+        ret = request_threaded_irq(line->irq_num, NULL, gpio_nested_irq_thread,
+                                   IRQF_TRIGGER_RISING | IRQF_TRIGGER_FALLING | IRQF_ONESHOT,
+                                   irq_name, line);
+        if (ret == 0)
+            pr_warn("[crowd_monitor] IRQ %d는 중첩 IRQ - 스레드에서 에지 시각을 기록 (타이밍 정밀도 낮음)\n",
+                    line->irq_num);
+    } else {
+        /* ONESHOT 없이 등록: 스레드가 도는 동안에도 하드 IRQ가 에지를 계속 기록 */
+        ret = request_threaded_irq(line->irq_num, gpio_interrupt_handler, gpio_irq_thread,
+                                   IRQF_TRIGGER_RISING | IRQF_TRIGGER_FALLING,
+                                   irq_name, line);
     }
+    if (ret == 0)
+        line->irq_enabled = true;
     
-    pr_info("[crowd_monitor] 신호 전송 완료: 타입 %d\n", signal_type);
-    return 0;
+    return ret;
 }
 
-/* 인터럽트 워크큐 핸들러 */
-static void irq_work_handler(struct work_struct *work) {
-    struct crowd_device *dev = container_of(work, struct crowd_device, irq_work);
+/*
+ * 인터럽트 해제. 먼저 disable_irq로 핸들러를 멈춰 마스크 해제 예약이 더 생기지 않게 한다.
+ * (disable 깊이는 다음 request_threaded_irq에서 초기화됨)
+ */
+static void crowd_line_free_irq(struct crowd_line *line) {
+    if (!line->irq_enabled)
+        return;
     
-    /* GPIO 상태 읽기 */
-    int gpio_value = gpiod_get_value(dev->gpio_desc);
+    disable_irq(line->irq_num);
+    cancel_delayed_work_sync(&line->unmask_work);
+    line->storm_masked = false;
     
-    if (gpio_value == 1) {  /* Rising edge - 신호 시작 */
-        dev->total_messages++;
-        pr_info("[crowd_monitor] 신호 수신 감지\n");
-        
-        /* 간단한 신호 해석 (실제로는 더 복잡한 프로토콜 필요) */
-        update_occupancy(dev, 1);  /* 임시로 입장으로 처리 */
-        
-        /* 대기 중인 read 프로세스 깨우기 */
-        wake_up_interruptible(&dev->read_wait);
-    }
+    free_irq(line->irq_num, line);
+    line->irq_enabled = false;
 }
 
-/* 인터럽트 핸들러 */
-static irqreturn_t gpio_interrupt_handler(int irq, void *dev_id) {
-    struct crowd_device *dev = (struct crowd_device *)dev_id;
+/* 인터럽트를 해제하고 라인을 출력(LOW)으로 전환 (공유선이면 놓아 둠) */
+static void crowd_line_set_output(struct crowd_line *line) {
+    if (!line->gpio_desc)
+        return;
     
-    /* 워크큐에 실제 처리 작업 스케줄링 */
-    schedule_work(&dev->irq_work);
+    crowd_line_free_irq(line);
+    if (line->open_drain)
+        crowd_od_release(line->gpio_desc);
+    else
+        gpiod_direction_output(line->gpio_desc, 0);
+}
+
+/* 공유선: 논리 1 = 선 LOW (하드 IRQ의 gpiod_get_value에도 적용), 처음엔 놓아 둠 */
+static void crowd_line_set_open_drain(struct crowd_line *line) {
+    if (!line->gpio_desc)
+        return;
     
-    return IRQ_HANDLED;
+    gpiod_toggle_active_low(line->gpio_desc);
+    crowd_od_release(line->gpio_desc);
+    line->open_drain = true;
 }
 
 /* ========== file_operations 함수들 ========== */
 
 static int crowd_fops_open(struct inode *inode, struct file *filp) {
     int minor = iminor(inode);
+    struct crowd_device *dev;
+    struct crowd_file *cf;
+    unsigned long flags;
     
     if (minor >= MAX_DEVICES || !devices[minor]) {
         return -ENODEV;
     }
+    dev = devices[minor];
+    
+    cf = kzalloc(sizeof(*cf), GFP_KERNEL);
+    if (!cf) {
+        return -ENOMEM;
+    }
+    
+    cf->dev = dev;
+    cf->max_events = 1;
+    INIT_KFIFO(cf->event_fifo);
+    init_waitqueue_head(&cf->wait);
+    hrtimer_setup(&cf->flush_timer, crowd_flush_timer_handler, CLOCK_MONOTONIC, HRTIMER_MODE_REL);
+    
+    spin_lock_irqsave(&dev->event_lock, flags);
+    list_add_tail(&cf->node, &dev->readers);
+    spin_unlock_irqrestore(&dev->event_lock, flags);
     
-    filp->private_data = devices[minor];
+    filp->private_data = cf;
     pr_info("[crowd_monitor] 디바이스 열림 (minor: %d)\n", minor);
     
     return 0;
 }
 
 static int crowd_fops_release(struct inode *inode, struct file *filp) {
+    struct crowd_file *cf = filp->private_data;
+    struct crowd_device *dev = cf->dev;
+    unsigned long flags;
+    
+    /* 목록에서 빼면 더 이상 타이머가 걸리지 않음 */
+    spin_lock_irqsave(&dev->event_lock, flags);
+    list_del(&cf->node);
+    spin_unlock_irqrestore(&dev->event_lock, flags);
+    hrtimer_cancel(&cf->flush_timer);
+    kfree(cf);
+    
     pr_info("[crowd_monitor] 디바이스 닫힘\n");
     return 0;
 }
 
+/* 이 파일에 대기 중인 이벤트를 limit 바이트 안에 들어가는 만큼 한 줄씩 꺼냄 (response는 limit + 1 이상) */
+static int crowd_file_drain(struct crowd_file *cf, char *response, size_t limit) {
+    struct crowd_device *dev = cf->dev;
+    unsigned long flags;
+    int response_len = 0;
+    struct crowd_event event;
+    char line[CROWD_EVENT_LINE_MAX + 1];
+    int n;
+    
+    spin_lock_irqsave(&dev->event_lock, flags);
+    while (kfifo_peek(&cf->event_fifo, &event)) {
+        if (cf->timestamps)
+            n = scnprintf(line, sizeof(line), "%s %llu\n", frame_type_name(event.type), event.ts_ns);
+        else
+            n = scnprintf(line, sizeof(line), "%s\n", frame_type_name(event.type));
+    
+        if (response_len + n > limit)
+            break;
+    
+        memcpy(response + response_len, line, n);
+        response_len += n;
+        kfifo_skip(&cf->event_fifo);
+    }
+    response[response_len] = '\0';
+    
+    /*
+     * 다 비웠으면 다음 묶음을 위해 병합 타이머를 처음부터.
+     * 사용자 버퍼가 작아 남았으면 이미 깨우기 조건을 넘긴 묶음이므로 다음 read에 바로 전달.
+     */
+    if (kfifo_is_empty(&cf->event_fifo)) {
+        cf->flush = false;
+        hrtimer_try_to_cancel(&cf->flush_timer);
+    } else {
+        cf->flush = true;
+    }
+    spin_unlock_irqrestore(&dev->event_lock, flags);
+    
+    return response_len;
+}
+
 static ssize_t crowd_fops_read(struct file *filp, char __user *buf, size_t len, loff_t *off) {
-    struct crowd_device *dev = filp->private_data;
-    char response[256];
+    struct crowd_file *cf = filp->private_data;
+    struct crowd_device *dev = cf->dev;
+    char *response;
     int response_len;
+    ssize_t ret;
     
     if (!dev) return -ENODEV;
     
-    /* 수신 모드에서는 GPIO 상태 변화 대기 */
+    response = kmalloc(CROWD_READ_BUF_SIZE + 1, GFP_KERNEL);
+    if (!response) {
+        return -ENOMEM;
+    }
+    
+    /* 수신 모드에서는 대기 중인 수신 이벤트를 한 줄씩 모아 반환 */
     if (dev->device_mode == MODE_RECEIVER) {
         if (filp->f_flags & O_NONBLOCK) {
-            /* 논블로킹 모드 - 즉시 현재 상태 반환 */
-        } else {
-            /* 블로킹 모드 - 신호 대기 */
-            if (wait_event_interruptible(dev->read_wait, 
-                                       dev->total_messages > 0)) {
-                return -ERESTARTSYS;
+            if (kfifo_is_empty(&cf->event_fifo)) {
+                ret = -EAGAIN;
+                goto out;
             }
+        } else if (wait_event_interruptible(cf->wait, crowd_file_ready(cf))) {
+            /* 블로킹 모드 - 깨우기 조건(이벤트 수/시간)까지 대기 */
+            ret = -ERESTARTSYS;
+            goto out;
+        }
+    
+        response_len = crowd_file_drain(cf, response, min_t(size_t, len, CROWD_READ_BUF_SIZE));
+    
+        if (response_len == 0) {
+            ret = -EINVAL;      /* 버퍼가 한 줄보다 작음 */
+            goto out;
         }
-        
-        response_len = snprintf(response, sizeof(response), "ENTER\n");
     } else {
         /* 송신 모드에서는 현재 상태 반환 */
         mutex_lock(&dev->device_lock);
-        response_len = snprintf(response, sizeof(response),
+        response_len = snprintf(response, CROWD_READ_BUF_SIZE + 1,
             "현재 인원: %d명\n임계값: %d명\n환기 상태: %s\n총 메시지: %lu개\n",
             dev->current_occupancy, dev->threshold,
             dev->ventilation_active ? "작동중" : "중지",
@@ -224,18 +1710,22 @@ static ssize_t crowd_fops_read(struct file *filp, char __user *buf, size_t len,
     }
     
     if (len < response_len) {
-        return -EINVAL;
-    }
-    
-    if (copy_to_user(buf, response, response_len)) {
-        return -EFAULT;
+        ret = -EINVAL;
+    } else if (copy_to_user(buf, response, response_len)) {
+        ret = -EFAULT;
+    } else {
+        ret = response_len;
     }
     
-    return response_len;
+out:
+    kfree(response);
+    return ret;
 }
 
 static ssize_t crowd_fops_write(struct file *filp, const char __user *buf, size_t len, loff_t *off) {
-    struct crowd_device *dev = filp->private_data;
+    struct crowd_file *cf = filp->private_data;
+    struct crowd_device *dev = cf->dev;
+    bool nonblock = filp->f_flags & O_NONBLOCK;
     char kbuf[32] = {0};
     int ret = 0;
     
@@ -257,19 +1747,19 @@ static ssize_t crowd_fops_write(struct file *filp, const char __user *buf, size_
     /* 명령 처리 */
     if (strcmp(kbuf, "ENTER") == 0) {
         if (dev->device_mode == MODE_TRANSMITTER) {
-            ret = send_signal(dev, 1);
+            ret = send_signal(dev, CROWD_FRAME_ENTER, nonblock);
         } else {
             update_occupancy(dev, 1);
         }
     } else if (strcmp(kbuf, "EXIT") == 0) {
         if (dev->device_mode == MODE_TRANSMITTER) {
-            ret = send_signal(dev, 2);
+            ret = send_signal(dev, CROWD_FRAME_EXIT, nonblock);
         } else {
             update_occupancy(dev, -1);
         }
     } else if (strcmp(kbuf, "STATUS") == 0) {
         if (dev->device_mode == MODE_TRANSMITTER) {
-            ret = send_signal(dev, 3);
+            ret = send_signal(dev, CROWD_FRAME_STATUS, nonblock);
         }
     } else {
         return -EINVAL;
@@ -279,7 +1769,10 @@ static ssize_t crowd_fops_write(struct file *filp, const char __user *buf, size_
 }
 
 static long crowd_fops_ioctl(struct file *filp, unsigned int cmd, unsigned long arg) {
-    struct crowd_device *dev = filp->private_data;
+    struct crowd_file *cf = filp->private_data;
+    struct crowd_device *dev = cf->dev;
+    struct crowd_coalesce coalesce;
+    unsigned long flags;
     int ret = 0;
     int value;
     
@@ -295,29 +1788,40 @@ static long crowd_fops_ioctl(struct file *filp, unsigned int cmd, unsigned long
             return -EINVAL;
         }
         
+        /* 센서 쌍 채널은 수신 전용 */
+        if (dev->beams && value == MODE_TRANSMITTER) {
+            return -EINVAL;
+        }
+    
+        mutex_lock(&dev->config_lock);
+        if (value != dev->device_mode) {
+            crowd_tx_reset(dev, false);
+        }
+    
         mutex_lock(&dev->device_lock);
         dev->device_mode = value;
+        mutex_unlock(&dev->device_lock);
         
-        /* GPIO 방향 설정 */
+        /* GPIO 방향 설정 (free_irq가 IRQ 스레드를 기다리므로 device_lock 밖에서) */
         if (value == MODE_TRANSMITTER) {
-            gpiod_direction_output(dev->gpio_desc, 0);
+            crowd_line_set_output(&dev->data_line);
+            crowd_bus_set_direction(&dev->bus, true);
             pr_info("[crowd_monitor] 송신 모드로 설정\n");
+    
+            /* ACK 복귀선 수신 */
+            ret = crowd_line_set_input(&dev->ack_line, "crowd_gpio_ack");
         } else {
-            gpiod_direction_input(dev->gpio_desc);
+            crowd_line_set_output(&dev->ack_line);
+            crowd_bus_set_direction(&dev->bus, false);
             pr_info("[crowd_monitor] 수신 모드로 설정\n");
             
             /* 인터럽트 설정 */
-            if (!dev->irq_enabled && dev->irq_num > 0) {
-                ret = request_irq(dev->irq_num, gpio_interrupt_handler,
-                                IRQF_TRIGGER_RISING | IRQF_TRIGGER_FALLING,
-                                "crowd_gpio_irq", dev);
-                if (ret == 0) {
-                    dev->irq_enabled = true;
-                    pr_info("[crowd_monitor] 인터럽트 활성화\n");
-                }
+            ret = crowd_line_set_input(&dev->data_line, "crowd_gpio_irq");
+            if (ret == 0 && dev->data_line.irq_enabled) {
+                pr_info("[crowd_monitor] 인터럽트 활성화\n");
             }
         }
-        mutex_unlock(&dev->device_lock);
+        mutex_unlock(&dev->config_lock);
         break;
         
     case GPIO_IOCTL_GET_COUNT:
@@ -330,13 +1834,23 @@ static long crowd_fops_ioctl(struct file *filp, unsigned int cmd, unsigned long
         }
         break;
         
-    case GPIO_IOCTL_RESET_COUNT:
+    case GPIO_IOCTL_RESET_COUNT: {
+        struct crowd_nl_state st;
+        bool changed;
+    
         mutex_lock(&dev->device_lock);
+        value = dev->current_occupancy;
+        changed = value != 0 || dev->ventilation_active;
         dev->current_occupancy = 0;
         dev->ventilation_active = false;
+        crowd_nl_snapshot(dev, -value, &st);
         mutex_unlock(&dev->device_lock);
         pr_info("[crowd_monitor] 카운터 리셋\n");
+    
+        if (changed)
+            crowd_nl_notify(&st);
         break;
+    }
         
     case GPIO_IOCTL_SET_THRESHOLD:
         if (copy_from_user(&value, (int __user *)arg, sizeof(int))) {
@@ -347,12 +1861,51 @@ static long crowd_fops_ioctl(struct file *filp, unsigned int cmd, unsigned long
             return -EINVAL;
         }
         
-        mutex_lock(&dev->device_lock);
-        dev->threshold = value;
-        mutex_unlock(&dev->device_lock);
+        crowd_set_threshold(dev, value);
         pr_info("[crowd_monitor] 임계값 설정: %d명\n", value);
         break;
         
+    case GPIO_IOCTL_SET_COALESCE:
+        if (copy_from_user(&coalesce, (void __user *)arg, sizeof(coalesce))) {
+            return -EFAULT;
+        }
+    
+        /* 시간 조건 없이 묶으면 마지막 묶음이 전달되지 않을 수 있음 */
+        if (coalesce.max_events < 1 || coalesce.max_events > CROWD_COALESCE_MAX_EVENTS ||
+            coalesce.max_usecs > CROWD_COALESCE_MAX_USECS ||
+            (coalesce.max_events > 1 && coalesce.max_usecs == 0)) {
+            return -EINVAL;
+        }
+    
+        /* 이미 쌓인 이벤트는 바로 전달하고 다음 묶음부터 새 조건 적용 */
+        hrtimer_cancel(&cf->flush_timer);
+        spin_lock_irqsave(&dev->event_lock, flags);
+        cf->max_events = coalesce.max_events;
+        cf->max_usecs = coalesce.max_usecs;
+        cf->flush = !kfifo_is_empty(&cf->event_fifo);
+        spin_unlock_irqrestore(&dev->event_lock, flags);
+        wake_up_interruptible(&cf->wait);
+        pr_info("[crowd_monitor] 깨우기 조절: %u개 / %uus\n",
+                coalesce.max_events, coalesce.max_usecs);
+        break;
+    
+    case GPIO_IOCTL_SET_EVENT_TS:
+        if (copy_from_user(&value, (int __user *)arg, sizeof(int))) {
+            return -EFAULT;
+        }
+    
+        WRITE_ONCE(cf->timestamps, value != 0);
+        break;
+    
+    case GPIO_IOCTL_GET_COALESCE:
+        coalesce.max_events = READ_ONCE(cf->max_events);
+        coalesce.max_usecs = READ_ONCE(cf->max_usecs);
+    
+        if (copy_to_user((void __user *)arg, &coalesce, sizeof(coalesce))) {
+            return -EFAULT;
+        }
+        break;
+    
     default:
         return -ENOTTY;
     }
@@ -360,12 +1913,30 @@ static long crowd_fops_ioctl(struct file *filp, unsigned int cmd, unsigned long
     return ret;
 }
 
+static __poll_t crowd_fops_poll(struct file *filp, poll_table *wait) {
+    struct crowd_file *cf = filp->private_data;
+    struct crowd_device *dev = cf->dev;
+    __poll_t mask = 0;
+    
+    poll_wait(filp, &cf->wait, wait);
+    poll_wait(filp, &dev->tx_wait, wait);
+    
+    /* 송신 모드의 read는 상태 문자열이므로 항상 읽을 수 있음 */
+    if (dev->device_mode != MODE_RECEIVER || crowd_file_ready(cf))
+        mask |= EPOLLIN | EPOLLRDNORM;
+    if (dev->device_mode != MODE_TRANSMITTER || crowd_tx_has_room(dev))
+        mask |= EPOLLOUT | EPOLLWRNORM;
+    
+    return mask;
+}
+
 static const struct file_operations crowd_fops = {
     .owner = THIS_MODULE,
     .open = crowd_fops_open,
     .read = crowd_fops_read,
     .write = crowd_fops_write,
     .release = crowd_fops_release,
+    .poll = crowd_fops_poll,
     .unlocked_ioctl = crowd_fops_ioctl,
 };
 
@@ -396,9 +1967,7 @@ static ssize_t threshold_store(struct device *dev, struct device_attribute *attr
         return -EINVAL;
     }
     
-    mutex_lock(&devices[minor]->device_lock);
-    devices[minor]->threshold = value;
-    mutex_unlock(&devices[minor]->device_lock);
+    crowd_set_threshold(devices[minor], value);
     
     return count;
 }
@@ -411,13 +1980,255 @@ static ssize_t mode_show(struct device *dev, struct device_attribute *attr, char
                     devices[minor]->device_mode == MODE_TRANSMITTER ? "transmitter" : "receiver");
 }
 
+static ssize_t zone_show(struct device *dev, struct device_attribute *attr, char *buf) {
+    int minor = MINOR(dev->devt);
+    if (minor >= MAX_DEVICES || !devices[minor]) return -ENODEV;
+    
+    return scnprintf(buf, PAGE_SIZE, "%u\n", READ_ONCE(devices[minor]->zone));
+}
+
+static ssize_t zone_store(struct device *dev, struct device_attribute *attr,
+                          const char *buf, size_t count) {
+    int minor = MINOR(dev->devt);
+    unsigned int value;
+    
+    if (minor >= MAX_DEVICES || !devices[minor]) return -ENODEV;
+    
+    if (kstrtouint(buf, 10, &value) < 0) {
+        return -EINVAL;
+    }
+    
+    mutex_lock(&devices[minor]->device_lock);
+    devices[minor]->zone = value;
+    mutex_unlock(&devices[minor]->device_lock);
+    
+    return count;
+}
+
+static ssize_t window_show(struct device *dev, struct device_attribute *attr, char *buf) {
+    int minor = MINOR(dev->devt);
+    if (minor >= MAX_DEVICES || !devices[minor]) return -ENODEV;
+    
+    return scnprintf(buf, PAGE_SIZE, "%u\n", devices[minor]->tx_window);
+}
+
+static ssize_t window_store(struct device *dev, struct device_attribute *attr,
+                            const char *buf, size_t count) {
+    int minor = MINOR(dev->devt);
+    unsigned int value;
+    
+    if (minor >= MAX_DEVICES || !devices[minor]) return -ENODEV;
+    
+    /* Go-Back-N: 윈도우는 시퀀스 공간보다 1 작아야 함 */
+    if (kstrtouint(buf, 10, &value) < 0 || value < 1 || value >= CROWD_SEQ_SPACE) {
+        return -EINVAL;
+    }
+    
+    WRITE_ONCE(devices[minor]->tx_window, value);
+    queue_work(crowd_wq, &devices[minor]->tx_work);
+    
+    return count;
+}
+
+static ssize_t link_stats_show(struct device *dev, struct device_attribute *attr, char *buf) {
+    int minor = MINOR(dev->devt);
+    struct crowd_device *crowd;
+    struct crowd_link_stats stats;
+    unsigned long flags;
+    u32 in_flight, queued;
+    
+    if (minor >= MAX_DEVICES || !devices[minor]) return -ENODEV;
+    crowd = devices[minor];
+    
+    spin_lock_irqsave(&crowd->tx_lock, flags);
+    stats = crowd->stats;
+    in_flight = crowd->tx_next - crowd->tx_base;
+    queued = crowd->tx_head - crowd->tx_base;
+    spin_unlock_irqrestore(&crowd->tx_lock, flags);
+    
+    return scnprintf(buf, PAGE_SIZE,
+        "link_mode: %s\nbus_width: %u\nack_line: %s\nwindow: %u\nin_flight: %u\nqueued: %u\n"
+        "frames_sent: %lu\nretransmits: %lu\ntimeouts: %lu\nresyncs_sent: %lu\n"
+        "acks_sent: %lu\nacks_received: %lu\n"
+        "frames_received: %lu\nout_of_order: %lu\nlost: %lu\n"
+        "crc_errors: %lu\nframing_errors: %lu\n"
+        "edge_overruns: %lu\nevent_overruns: %lu\n"
+        "rtt_last_us: %lld\nrtt_min_us: %lld\nrtt_avg_us: %lld\nrtt_max_us: %lld\n",
+        crowd->bus.width ? "bus" : "serial", crowd->bus.width,
+        crowd_ack_enabled(crowd) ? "on" : "off",
+        crowd->tx_window, in_flight, queued,
+        stats.frames_sent, stats.retransmits, stats.timeouts, stats.resyncs_sent,
+        stats.acks_sent, stats.acks_received,
+        stats.frames_received, stats.out_of_order, stats.lost,
+        stats.crc_errors, stats.framing_errors,
+        stats.edge_overruns, stats.event_overruns,
+        stats.rtt_last_us, stats.rtt_min_us, stats.rtt_avg_us, stats.rtt_max_us);
+}
+
+/* 공유선 노드 통계: 이 송신기의 충돌/백오프와 수신한 노드별 처리량, 출입 수 */
+static ssize_t node_stats_show(struct device *dev, struct device_attribute *attr, char *buf) {
+    int minor = MINOR(dev->devt);
+    struct crowd_device *crowd;
+    struct crowd_link_stats stats;
+    unsigned long flags;
+    u64 now = ktime_get_ns();
+    int len, n;
+    
+    if (minor >= MAX_DEVICES || !devices[minor]) return -ENODEV;
+    crowd = devices[minor];
+    
+    spin_lock_irqsave(&crowd->tx_lock, flags);
+    stats = crowd->stats;
+    spin_unlock_irqrestore(&crowd->tx_lock, flags);
+    
+    len = scnprintf(buf, PAGE_SIZE,
+        "multidrop: %s\nnode_id: %u\n"
+        "collisions: %lu\nlbt_busy: %lu\nbackoffs: %lu\ntx_aborts: %lu\nunknown_node: %lu\n"
+        "resyncs: %lu\n",
+        crowd->data_line.open_drain ? "on" : "off", node_id,
+        stats.collisions, stats.lbt_busy, stats.backoffs, stats.tx_aborts, stats.unknown_node,
+        stats.resyncs);
+    
+    /* 처리량 = 첫 프레임부터 마지막 프레임까지의 평균 (frames/s, 소수 2자리) */
+    for (n = 0; n < CROWD_MAX_NODES; n++) {
+        const struct crowd_node *node = &crowd->nodes[n];
+        unsigned long frames = READ_ONCE(node->frames);
+        u64 span_ms, rate;
+        u32 frac;
+    
+        if (!frames)
+            continue;
+    
+        span_ms = div_u64(node->last_ns - node->first_ns, NSEC_PER_MSEC);
+        rate = span_ms ? div64_u64((u64)(frames - 1) * 100 * MSEC_PER_SEC, span_ms) : 0;
+        rate = div_u64_rem(rate, 100, &frac);
+    
+        len += scnprintf(buf + len, PAGE_SIZE - len,
+            "node %d: frames %lu enters %lu exits %lu lost %lu out_of_order %lu "
+            "fps %llu.%02u idle_ms %llu\n",
+            n, frames, node->enters, node->exits, node->lost, node->out_of_order,
+            rate, frac, div_u64(now - node->last_ns, NSEC_PER_MSEC));
+    }
+    return len;
+}
+
+static ssize_t max_edge_rate_show(struct device *dev, struct device_attribute *attr, char *buf) {
+    int minor = MINOR(dev->devt);
+    if (minor >= MAX_DEVICES || !devices[minor]) return -ENODEV;
+    
+    return scnprintf(buf, PAGE_SIZE, "%u\n", READ_ONCE(devices[minor]->data_line.max_edge_rate));
+}
+
+static ssize_t max_edge_rate_store(struct device *dev, struct device_attribute *attr,
+                                   const char *buf, size_t count) {
+    int minor = MINOR(dev->devt);
+    unsigned int value;
+    
+    if (minor >= MAX_DEVICES || !devices[minor]) return -ENODEV;
+    
+    if (kstrtouint(buf, 10, &value) < 0) {
+        return -EINVAL;
+    }
+    
+    /* 디바이스의 데이터선과 ACK 복귀선 (센서 쌍이면 두 빔)에 모두 적용 */
+    WRITE_ONCE(devices[minor]->data_line.max_edge_rate, value);
+    WRITE_ONCE(devices[minor]->ack_line.max_edge_rate, value);
+    if (devices[minor]->beams) {
+        WRITE_ONCE(devices[minor]->beams->beam[CROWD_BEAM_A].max_edge_rate, value);
+        WRITE_ONCE(devices[minor]->beams->beam[CROWD_BEAM_B].max_edge_rate, value);
+    }
+    
+    return count;
+}
+
+static int crowd_line_irq_stats(const struct crowd_line *line, const char *name,
+                                char *buf, int len) {
+    if (!line->gpio_desc)
+        return len;
+    
+    return len + scnprintf(buf + len, PAGE_SIZE - len,
+        "%s: irq %d edges %lu storms %lu masked %s backoff_ms %u nested %s\n",
+        name, line->irq_num, line->edges, line->storms,
+        READ_ONCE(line->storm_masked) ? "yes" : "no", line->storm_backoff,
+        line->irq_nested ? "yes" : "no");
+}
+
+static ssize_t irq_stats_show(struct device *dev, struct device_attribute *attr, char *buf) {
+    int minor = MINOR(dev->devt);
+    int len = 0;
+    
+    if (minor >= MAX_DEVICES || !devices[minor]) return -ENODEV;
+    
+    len = crowd_line_irq_stats(&devices[minor]->data_line, "data", buf, len);
+    len = crowd_line_irq_stats(&devices[minor]->ack_line, "ack", buf, len);
+    if (devices[minor]->beams) {
+        len = crowd_line_irq_stats(&devices[minor]->beams->beam[CROWD_BEAM_A], "beam_a", buf, len);
+        len = crowd_line_irq_stats(&devices[minor]->beams->beam[CROWD_BEAM_B], "beam_b", buf, len);
+    }
+    return len;
+}
+
+/* 센서 쌍 판정 구간 (센서 쌍 채널에만 생성) */
+#define CROWD_BEAM_WINDOW_ATTR(_name)                                                   \
+static ssize_t beam_##_name##_show(struct device *dev, struct device_attribute *attr,   \
+                                   char *buf) {                                         \
+    int minor = MINOR(dev->devt);                                                       \
+    if (minor >= MAX_DEVICES || !devices[minor] || !devices[minor]->beams)              \
+        return -ENODEV;                                                                 \
+    return scnprintf(buf, PAGE_SIZE, "%u\n", READ_ONCE(devices[minor]->beams->_name)); \
+}                                                                                       \
+static ssize_t beam_##_name##_store(struct device *dev, struct device_attribute *attr,  \
+                                    const char *buf, size_t count) {                    \
+    int minor = MINOR(dev->devt);                                                       \
+    unsigned int value;                                                                 \
+    if (minor >= MAX_DEVICES || !devices[minor] || !devices[minor]->beams)              \
+        return -ENODEV;                                                                 \
+    if (kstrtouint(buf, 10, &value) < 0)                                                \
+        return -EINVAL;                                                                 \
+    WRITE_ONCE(devices[minor]->beams->_name, value);                                    \
+    return count;                                                                       \
+}                                                                                       \
+static DEVICE_ATTR_RW(beam_##_name)
+
+CROWD_BEAM_WINDOW_ATTR(min_break_us);
+CROWD_BEAM_WINDOW_ATTR(max_gap_ms);
+CROWD_BEAM_WINDOW_ATTR(max_cross_ms);
+
+static ssize_t beam_stats_show(struct device *dev, struct device_attribute *attr, char *buf) {
+    int minor = MINOR(dev->devt);
+    struct crowd_beam_pair *pair;
+    ssize_t len;
+    
+    if (minor >= MAX_DEVICES || !devices[minor] || !devices[minor]->beams) return -ENODEV;
+    pair = devices[minor]->beams;
+    
+    spin_lock(&pair->lock);
+    len = scnprintf(buf, PAGE_SIZE,
+        "enters: %lu\nexits: %lu\nbounces: %lu\ntimeouts: %lu\nglitches: %lu\n"
+        "beam_a: %s\nbeam_b: %s\n",
+        pair->enters, pair->exits, pair->bounces, pair->timeouts, pair->glitches,
+        pair->broken[CROWD_BEAM_A] ? "broken" : "clear",
+        pair->broken[CROWD_BEAM_B] ? "broken" : "clear");
+    spin_unlock(&pair->lock);
+    
+    return len;
+}
+
 static DEVICE_ATTR_RO(occupancy);
 static DEVICE_ATTR_RW(threshold);
 static DEVICE_ATTR_RO(mode);
+static DEVICE_ATTR_RW(zone);
+static DEVICE_ATTR_RW(window);
+static DEVICE_ATTR_RO(link_stats);
+static DEVICE_ATTR_RO(node_stats);
+static DEVICE_ATTR_RW(max_edge_rate);
+static DEVICE_ATTR_RO(irq_stats);
+static DEVICE_ATTR_RO(beam_stats);
 
 /* ========== 모듈 초기화/종료 ========== */
 
-static int create_crowd_device(int minor, int gpio_pin) {
+static int create_crowd_device(int minor, int gpio_pin, int ack_pin,
+                               const int *bus_pins, int bus_width) {
     struct crowd_device *dev;
     int ret;
     
@@ -427,11 +2238,14 @@ static int create_crowd_device(int minor, int gpio_pin) {
     }
     
     /* GPIO 설정 */
-    dev->gpio_desc = gpio_to_desc(gpio_pin);
-    if (!dev->gpio_desc) {
-        pr_err("[crowd_monitor] GPIO %d 획득 실패\n", gpio_pin);
+    ret = crowd_line_init(dev, &dev->data_line, gpio_pin);
+    if (!ret)
+        ret = crowd_line_init(dev, &dev->ack_line, ack_pin);
+    if (!ret)
+        ret = crowd_bus_init(dev, bus_pins, bus_width);
+    if (ret) {
         kfree(dev);
-        return -ENODEV;
+        return ret;
     }
     
     /* 기본값 설정 */
@@ -440,19 +2254,19 @@ static int create_crowd_device(int minor, int gpio_pin) {
     dev->threshold = 50;
     dev->ventilation_active = false;
     dev->total_messages = 0;
-    dev->irq_enabled = false;
+    dev->tx_window = 4;
+    dev->tx_sync = true;        /* 모듈 재적재 후 수신측이 이전 시퀀스를 기대하고 있을 수 있음 */
     
     /* 동기화 객체 초기화 */
     mutex_init(&dev->device_lock);
-    init_waitqueue_head(&dev->read_wait);
-    INIT_WORK(&dev->irq_work, irq_work_handler);
-    
-    /* 인터럽트 번호 획득 */
-    dev->irq_num = gpiod_to_irq(dev->gpio_desc);
-    if (dev->irq_num < 0) {
-        pr_warn("[crowd_monitor] GPIO %d 인터럽트 번호 획득 실패\n", gpio_pin);
-        dev->irq_num = 0;
-    }
+    mutex_init(&dev->config_lock);
+    spin_lock_init(&dev->event_lock);
+    spin_lock_init(&dev->tx_lock);
+    init_waitqueue_head(&dev->tx_wait);
+    INIT_LIST_HEAD(&dev->readers);
+    INIT_WORK(&dev->tx_work, tx_work_handler);
+    INIT_WORK(&dev->ack_work, ack_work_handler);
+    timer_setup(&dev->rtx_timer, rtx_timer_handler, 0);
     
     /* 디바이스 생성 */
     dev->dev = device_create(crowd_class, NULL, 
@@ -469,36 +2283,131 @@ static int create_crowd_device(int minor, int gpio_pin) {
     device_create_file(dev->dev, &dev_attr_occupancy);
     device_create_file(dev->dev, &dev_attr_threshold);
     device_create_file(dev->dev, &dev_attr_mode);
+    device_create_file(dev->dev, &dev_attr_zone);
+    device_create_file(dev->dev, &dev_attr_window);
+    device_create_file(dev->dev, &dev_attr_link_stats);
+    device_create_file(dev->dev, &dev_attr_node_stats);
+    device_create_file(dev->dev, &dev_attr_max_edge_rate);
+    device_create_file(dev->dev, &dev_attr_irq_stats);
+    
+    /* 공유선이면 송신/수신 데이터선 모두 오픈 드레인 (센서 쌍 채널은 데이터선 없음) */
+    if (multidrop)
+        crowd_line_set_open_drain(&dev->data_line);
     
     devices[minor] = dev;
-    pr_info("[crowd_monitor] 디바이스 %d 생성 완료 (GPIO %d)\n", minor, gpio_pin);
+    pr_info("[crowd_monitor] 디바이스 %d 생성 완료 (GPIO %d, ACK GPIO %d)\n",
+            minor, gpio_pin, ack_pin);
     
     return 0;
 }
 
-static void destroy_crowd_device(int minor) {
-    struct crowd_device *dev = devices[minor];
+/* 센서 쌍 채널: 두 빔을 입력으로 두고 IRQ를 바로 등록 (수신 전용이라 모드 전환 없음) */
+static int crowd_beam_init(struct crowd_device *dev, int a_pin, int b_pin) {
+    static const char *const irq_names[CROWD_BEAM_COUNT] = { "crowd_beam_a", "crowd_beam_b" };
+    const int pins[CROWD_BEAM_COUNT] = { a_pin, b_pin };
+    struct crowd_beam_pair *pair;
+    int i, ret;
     
-    if (!dev) return;
+    if (a_pin < 0 || b_pin < 0) {
+        pr_err("[crowd_monitor] 센서 쌍에는 beam_a_pin과 beam_b_pin이 모두 필요합니다\n");
+        return -EINVAL;
+    }
     
-    /* 인터럽트 해제 */
-    if (dev->irq_enabled) {
-        free_irq(dev->irq_num, dev);
+    pair = kzalloc(sizeof(*pair), GFP_KERNEL);
+    if (!pair) {
+        return -ENOMEM;
+    }
+    
+    spin_lock_init(&pair->lock);
+    crowd_beam_reset(pair);
+    pair->min_break_us = beam_min_break_us;
+    pair->max_gap_ms = beam_max_gap_ms;
+    pair->max_cross_ms = beam_max_cross_ms;
+    dev->beams = pair;
+    
+    for (i = 0; i < CROWD_BEAM_COUNT; i++) {
+        struct crowd_line *line = &pair->beam[i];
+    
+        ret = crowd_line_init(dev, line, pins[i]);
+        if (ret)
+            return ret;
+        line->pair = pair;
+    
+        /* 논리 레벨 1 = 빔 차단 (하드 IRQ의 gpiod_get_value에도 적용) */
+        if (beam_active_low)
+            gpiod_toggle_active_low(line->gpio_desc);
+    
+        ret = crowd_line_set_input(line, irq_names[i]);
+        if (ret) {
+            pr_err("[crowd_monitor] 빔 GPIO %d 인터럽트 등록 실패: %d\n", pins[i], ret);
+            return ret;
+        }
+        pair->broken[i] = line->last_level;
+    }
+    
+    device_create_file(dev->dev, &dev_attr_beam_min_break_us);
+    device_create_file(dev->dev, &dev_attr_beam_max_gap_ms);
+    device_create_file(dev->dev, &dev_attr_beam_max_cross_ms);
+    device_create_file(dev->dev, &dev_attr_beam_stats);
+    
+    pr_info("[crowd_monitor] 센서 쌍: 빔 A GPIO %d (바깥쪽), 빔 B GPIO %d (안쪽)\n", a_pin, b_pin);
+    return 0;
+}
+
+static void crowd_beam_destroy(struct crowd_device *dev) {
+    struct crowd_beam_pair *pair = dev->beams;
+    int i;
+    
+    if (!pair) return;
+    
+    device_remove_file(dev->dev, &dev_attr_beam_min_break_us);
+    device_remove_file(dev->dev, &dev_attr_beam_max_gap_ms);
+    device_remove_file(dev->dev, &dev_attr_beam_max_cross_ms);
+    device_remove_file(dev->dev, &dev_attr_beam_stats);
+    
+    for (i = 0; i < CROWD_BEAM_COUNT; i++) {
+        crowd_line_free_irq(&pair->beam[i]);
+        if (beam_active_low && pair->beam[i].gpio_desc)
+            gpiod_toggle_active_low(pair->beam[i].gpio_desc);
     }
     
-    /* 워크큐 정리 */
-    cancel_work_sync(&dev->irq_work);
+    dev->beams = NULL;
+    kfree(pair);
+}
+
+static void destroy_crowd_device(int minor) {
+    struct crowd_device *dev = devices[minor];
+    
+    if (!dev) return;
     
-    /* sysfs 속성 제거 */
+    /* sysfs 속성 제거 (window_store가 tx_work를 큐에 넣지 못하도록 송신 정리보다 먼저) */
     device_remove_file(dev->dev, &dev_attr_occupancy);
     device_remove_file(dev->dev, &dev_attr_threshold);
     device_remove_file(dev->dev, &dev_attr_mode);
+    device_remove_file(dev->dev, &dev_attr_zone);
+    device_remove_file(dev->dev, &dev_attr_window);
+    device_remove_file(dev->dev, &dev_attr_link_stats);
+    device_remove_file(dev->dev, &dev_attr_node_stats);
+    device_remove_file(dev->dev, &dev_attr_max_edge_rate);
+    device_remove_file(dev->dev, &dev_attr_irq_stats);
+    
+    /* 인터럽트 해제 */
+    crowd_line_free_irq(&dev->data_line);
+    crowd_line_free_irq(&dev->ack_line);
+    crowd_beam_destroy(dev);
+    if (dev->data_line.open_drain)
+        gpiod_toggle_active_low(dev->data_line.gpio_desc);
+    
+    /* 워크큐 / 타이머 정리 (IRQ와 window 속성이 없어져 더는 다시 큐에 넣을 곳이 없음) */
+    crowd_tx_reset(dev, true);
+    cancel_work_sync(&dev->ack_work);
     
     /* 디바이스 제거 */
     device_destroy(crowd_class, MKDEV(major_num, minor));
     
     /* 메모리 해제 */
     mutex_destroy(&dev->device_lock);
+    mutex_destroy(&dev->config_lock);
     kfree(dev);
     devices[minor] = NULL;
     
@@ -510,6 +2419,16 @@ static int __init crowd_driver_init(void) {
     
     pr_info("[crowd_monitor] GPIO 17-26 연결 기반 IoT 드라이버 초기화\n");
     
+    /* 공유선은 데이터선 하나만 오픈 드레인으로 구동 (병렬 버스 데이터선은 푸시풀) */
+    if (multidrop && (bus_tx_width || bus_rx_width)) {
+        pr_err("[crowd_monitor] multidrop은 병렬 버스 모드와 함께 쓸 수 없습니다\n");
+        return -EINVAL;
+    }
+    if (node_id >= CROWD_MAX_NODES) {
+        pr_err("[crowd_monitor] 지원하지 않는 노드 ID: %u (0~%d)\n", node_id, CROWD_MAX_NODES - 1);
+        return -EINVAL;
+    }
+    
     /* 문자 디바이스 번호 할당 */
     ret = alloc_chrdev_region(&dev_num_base, 0, MAX_DEVICES, DEVICE_NAME);
     if (ret) {
@@ -529,33 +2448,73 @@ static int __init crowd_driver_init(void) {
         return ret;
     }
     
+    /* 링크 송신용 워크큐 (데이터 프레임과 ACK가 서로 막지 않도록 unbound) */
+    crowd_wq = alloc_workqueue("crowd_link", WQ_UNBOUND, 0);
+    if (!crowd_wq) {
+        cdev_del(&crowd_cdev);
+        unregister_chrdev_region(dev_num_base, MAX_DEVICES);
+        return -ENOMEM;
+    }
+    
     /* 클래스 생성 */
     crowd_class = class_create(CLASS_NAME);
     if (IS_ERR(crowd_class)) {
         ret = PTR_ERR(crowd_class);
         pr_err("[crowd_monitor] 클래스 생성 실패: %d\n", ret);
+        destroy_workqueue(crowd_wq);
         cdev_del(&crowd_cdev);
         unregister_chrdev_region(dev_num_base, MAX_DEVICES);
         return ret;
     }
     
+    /* netlink 패밀리 등록 (디바이스가 알림을 보내기 전에) */
+    ret = genl_register_family(&crowd_nl_family);
+    if (ret) {
+        pr_err("[crowd_monitor] netlink 패밀리 등록 실패: %d\n", ret);
+        goto err_genl;
+    }
+    
     /* 디바이스 생성 */
-    ret = create_crowd_device(0, GPIO_TX_PIN);  /* /dev/crowd_gpio0 - 송신용 */
-    if (ret) goto err_dev0;
+    /* 버스 모드면 스트로브가 데이터선 역할 */
+    ret = create_crowd_device(0, bus_tx_width ? bus_tx_strobe_pin : tx_pin, ack_rx_pin,
+                              bus_tx_pins, bus_tx_width);  /* /dev/crowd_gpio0 - 송신용 */
+    if (ret) goto err_dev;
+    
+    ret = create_crowd_device(1, bus_rx_width ? bus_rx_strobe_pin : rx_pin, ack_tx_pin,
+                              bus_rx_pins, bus_rx_width);  /* /dev/crowd_gpio1 - 수신용 */
+    if (ret) goto err_dev;
+    
+    /* 센서 쌍 채널 (빔 핀을 지정한 경우만) - /dev/crowd_gpio2 */
+    if (beam_a_pin >= 0 || beam_b_pin >= 0) {
+        ret = create_crowd_device(CROWD_BEAM_MINOR, -1, -1, NULL, 0);
+        if (ret) goto err_dev;
     
-    ret = create_crowd_device(1, GPIO_RX_PIN);  /* /dev/crowd_gpio1 - 수신용 */
-    if (ret) goto err_dev1;
+        ret = crowd_beam_init(devices[CROWD_BEAM_MINOR], beam_a_pin, beam_b_pin);
+        if (ret) goto err_dev;
+    }
     
     pr_info("[crowd_monitor] 드라이버 초기화 완료\n");
-    pr_info("[crowd_monitor] 송신: /dev/crowd_gpio0 (GPIO %d)\n", GPIO_TX_PIN);
-    pr_info("[crowd_monitor] 수신: /dev/crowd_gpio1 (GPIO %d)\n", GPIO_RX_PIN);
+    pr_info("[crowd_monitor] 송신: /dev/crowd_gpio0 (GPIO %d)\n", tx_pin);
+    pr_info("[crowd_monitor] 수신: /dev/crowd_gpio1 (GPIO %d)\n", rx_pin);
+    if (ack_tx_pin >= 0 && ack_rx_pin >= 0)
+        pr_info("[crowd_monitor] ACK 복귀선: GPIO %d → GPIO %d\n", ack_tx_pin, ack_rx_pin);
+    if (bus_tx_width || bus_rx_width)
+        pr_info("[crowd_monitor] 병렬 버스: 송신 %d비트 (스트로브 GPIO %d), 수신 %d비트 (스트로브 GPIO %d)\n",
+                bus_tx_width, bus_tx_strobe_pin, bus_rx_width, bus_rx_strobe_pin);
+    if (multidrop)
+        pr_info("[crowd_monitor] 공유선 (오픈 드레인): 노드 ID %u\n", node_id);
     
     return 0;
 
-err_dev1:
+err_dev:
+    /* netlink 요청이 해제 중인 디바이스를 읽지 않도록 패밀리부터 (만들지 못한 디바이스는 건너뜀) */
+    genl_unregister_family(&crowd_nl_family);
+    destroy_crowd_device(CROWD_BEAM_MINOR);
+    destroy_crowd_device(1);
     destroy_crowd_device(0);
-err_dev0:
+err_genl:
     class_destroy(crowd_class);
+    destroy_workqueue(crowd_wq);
     cdev_del(&crowd_cdev);
     unregister_chrdev_region(dev_num_base, MAX_DEVICES);
     return ret;
@@ -564,13 +2523,23 @@ err_dev0:
 static void __exit crowd_driver_exit(void) {
     pr_info("[crowd_monitor] 드라이버 종료 시작\n");
     
+    /*
+     * netlink 패밀리 해제를 디바이스 제거보다 먼저: 해제가 끝나면 진행 중이던 doit/dump도
+     * 끝나 있고 새 요청은 들어오지 않으며, 구독자가 없어져 crowd_nl_notify도 바로 반환함
+     */
+    genl_unregister_family(&crowd_nl_family);
+    
     /* 디바이스 제거 */
     destroy_crowd_device(0);
     destroy_crowd_device(1);
+    destroy_crowd_device(CROWD_BEAM_MINOR);
     
     /* 클래스 제거 */
     class_destroy(crowd_class);
     
+    /* 워크큐 제거 */
+    destroy_workqueue(crowd_wq);
+    
     /* cdev 제거 */
     struct cdev crowd_cdev;
     cdev_del(&crowd_cdev);
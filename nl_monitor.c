@@ -0,0 +1,321 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <unistd.h>
+#include <string.h>
+#include <signal.h>
+#include <errno.h>
+#include <time.h>
+#include <sys/socket.h>
+#include <linux/netlink.h>
+#include <linux/genetlink.h>
+
+/*
+ * generic netlink 구독 프로그램
+ * 드라이버의 "crowd_monitor" 패밀리에서 전체 채널 상태를 덤프한 뒤
+ * "events" 멀티캐스트 그룹의 인원/환기 변경 알림을 출력한다.
+ * (디바이스 파일을 열지 않으므로 여러 서비스가 동시에 구독 가능)
+ */
+
+/* 드라이버 gpio_drv.c와 동일한 정의 */
+#define CROWD_NL_FAMILY_NAME "crowd_monitor"
+#define CROWD_NL_MCGRP_NAME "events"
+#define CROWD_NL_CMD_GET 1
+#define CROWD_NL_CMD_CHANGE 2
+
+enum {
+    CROWD_NL_ATTR_UNSPEC,
+    CROWD_NL_ATTR_PAD,
+    CROWD_NL_ATTR_CHANNEL,
+    CROWD_NL_ATTR_ZONE,
+    CROWD_NL_ATTR_DELTA,
+    CROWD_NL_ATTR_OCCUPANCY,
+    CROWD_NL_ATTR_THRESHOLD,
+    CROWD_NL_ATTR_VENTILATION,
+    CROWD_NL_ATTR_TIMESTAMP,
+    CROWD_NL_ATTR_MODE,
+    __CROWD_NL_ATTR_MAX,
+};
+
+#define MODE_TRANSMITTER 1
+#define RECV_BUF_SIZE 8192
+
+/* 헤더 뒤 속성 영역 */
+#define GENL_ATTRS(nlh) ((struct nlattr *)((char *)NLMSG_DATA(nlh) + GENL_HDRLEN))
+#define GENL_ATTRS_LEN(nlh) ((int)(nlh)->nlmsg_len - NLMSG_LENGTH(GENL_HDRLEN))
+#define NLA_DATA(nla) ((void *)((char *)(nla) + NLA_HDRLEN))
+#define NLA_OK(nla, len) ((len) >= (int)sizeof(struct nlattr) && \
+                          (nla)->nla_len >= sizeof(struct nlattr) && (nla)->nla_len <= (len))
+#define NLA_NEXT(nla, len) ((len) -= NLA_ALIGN((nla)->nla_len), \
+                            (struct nlattr *)((char *)(nla) + NLA_ALIGN((nla)->nla_len)))
+
+static volatile sig_atomic_t running = 1;
+static uint32_t seq_counter = 1;
+
+void signal_handler(int sig) {
+    running = 0;
+}
+
+void print_usage(const char *prog_name) {
+    printf("사용법: %s [옵션]\n", prog_name);
+    printf("옵션:\n");
+    printf("  -d, --dump         전체 채널 상태만 출력하고 종료\n");
+    printf("  -c, --channel N    채널 N 상태만 조회하고 종료\n");
+    printf("  -h, --help         도움말\n");
+    printf("옵션 없이 실행하면 상태 덤프 후 변경 알림을 계속 출력\n");
+}
+
+/* 속성을 타입별 배열로 분류 (중첩 속성 포함) */
+void parse_attrs(struct nlattr *nla, int len, struct nlattr **tb, int max) {
+    memset(tb, 0, sizeof(*tb) * (max + 1));
+    for (; NLA_OK(nla, len); nla = NLA_NEXT(nla, len)) {
+        int type = nla->nla_type & NLA_TYPE_MASK;
+        if (type <= max) tb[type] = nla;
+    }
+}
+
+int put_attr(struct nlmsghdr *nlh, int type, const void *data, int len) {
+    struct nlattr *nla = (struct nlattr *)((char *)nlh + NLMSG_ALIGN(nlh->nlmsg_len));
+    nla->nla_type = type;
+    nla->nla_len = NLA_HDRLEN + len;
+    memcpy(NLA_DATA(nla), data, len);
+    nlh->nlmsg_len = NLMSG_ALIGN(nlh->nlmsg_len) + NLA_ALIGN(nla->nla_len);
+    return 0;
+}
+
+/* genl 요청 한 건 전송 (buf에 헤더를 만들고 속성은 호출자가 추가한 뒤 send_request) */
+struct nlmsghdr *init_request(char *buf, uint16_t family, uint8_t cmd, uint16_t flags) {
+    struct nlmsghdr *nlh = (struct nlmsghdr *)buf;
+    struct genlmsghdr *genl = NLMSG_DATA(nlh);
+
+    memset(buf, 0, NLMSG_LENGTH(GENL_HDRLEN));
+    nlh->nlmsg_len = NLMSG_LENGTH(GENL_HDRLEN);
+    nlh->nlmsg_type = family;
+    nlh->nlmsg_flags = NLM_F_REQUEST | flags;
+    nlh->nlmsg_seq = seq_counter++;
+    genl->cmd = cmd;
+    genl->version = 1;
+    return nlh;
+}
+
+int send_request(int sock, struct nlmsghdr *nlh) {
+    struct sockaddr_nl addr = { .nl_family = AF_NETLINK };
+    if (sendto(sock, nlh, nlh->nlmsg_len, 0, (struct sockaddr *)&addr, sizeof(addr)) < 0) {
+        perror("netlink 전송 실패");
+        return -1;
+    }
+    return 0;
+}
+
+/* "crowd_monitor" 패밀리 ID와 "events" 그룹 ID 조회 */
+int resolve_family(int sock, uint16_t *family_id, uint32_t *group_id) {
+    char buf[RECV_BUF_SIZE];
+    struct nlmsghdr *nlh = init_request(buf, GENL_ID_CTRL, CTRL_CMD_GETFAMILY, 0);
+
+    put_attr(nlh, CTRL_ATTR_FAMILY_NAME, CROWD_NL_FAMILY_NAME, strlen(CROWD_NL_FAMILY_NAME) + 1);
+    if (send_request(sock, nlh) < 0) return -1;
+
+    int len = recv(sock, buf, sizeof(buf), 0);
+    if (len < 0) {
+        perror("netlink 수신 실패");
+        return -1;
+    }
+
+    nlh = (struct nlmsghdr *)buf;
+    if (!NLMSG_OK(nlh, len) || nlh->nlmsg_type == NLMSG_ERROR) {
+        printf("netlink 패밀리 %s 없음 (드라이버 로드 확인: sudo make load)\n", CROWD_NL_FAMILY_NAME);
+        return -1;
+    }
+
+    struct nlattr *tb[CTRL_ATTR_MAX + 1];
+    parse_attrs(GENL_ATTRS(nlh), GENL_ATTRS_LEN(nlh), tb, CTRL_ATTR_MAX);
+    if (!tb[CTRL_ATTR_FAMILY_ID] || !tb[CTRL_ATTR_MCAST_GROUPS]) {
+        printf("패밀리 정보 파싱 실패\n");
+        return -1;
+    }
+    *family_id = *(uint16_t *)NLA_DATA(tb[CTRL_ATTR_FAMILY_ID]);
+
+    /* 멀티캐스트 그룹 목록: 중첩 속성 안에 그룹마다 이름/ID */
+    struct nlattr *grp = NLA_DATA(tb[CTRL_ATTR_MCAST_GROUPS]);
+    int grp_len = tb[CTRL_ATTR_MCAST_GROUPS]->nla_len - NLA_HDRLEN;
+    for (; NLA_OK(grp, grp_len); grp = NLA_NEXT(grp, grp_len)) {
+        struct nlattr *gtb[CTRL_ATTR_MCAST_GRP_MAX + 1];
+        parse_attrs(NLA_DATA(grp), grp->nla_len - NLA_HDRLEN, gtb, CTRL_ATTR_MCAST_GRP_MAX);
+
+        if (gtb[CTRL_ATTR_MCAST_GRP_NAME] && gtb[CTRL_ATTR_MCAST_GRP_ID] &&
+            strcmp(NLA_DATA(gtb[CTRL_ATTR_MCAST_GRP_NAME]), CROWD_NL_MCGRP_NAME) == 0) {
+            *group_id = *(uint32_t *)NLA_DATA(gtb[CTRL_ATTR_MCAST_GRP_ID]);
+            return 0;
+        }
+    }
+
+    printf("멀티캐스트 그룹 %s 없음\n", CROWD_NL_MCGRP_NAME);
+    return -1;
+}
+
+void print_state(struct nlmsghdr *nlh) {
+    struct genlmsghdr *genl = NLMSG_DATA(nlh);
+    struct nlattr *tb[__CROWD_NL_ATTR_MAX];
+    char time_str[32] = "-";
+
+    parse_attrs(GENL_ATTRS(nlh), GENL_ATTRS_LEN(nlh), tb, __CROWD_NL_ATTR_MAX - 1);
+    if (!tb[CROWD_NL_ATTR_CHANNEL] || !tb[CROWD_NL_ATTR_OCCUPANCY]) return;
+
+    if (tb[CROWD_NL_ATTR_TIMESTAMP]) {
+        uint64_t ts_ns;
+        memcpy(&ts_ns, NLA_DATA(tb[CROWD_NL_ATTR_TIMESTAMP]), sizeof(ts_ns));
+        time_t sec = ts_ns / 1000000000ULL;
+        size_t n = strftime(time_str, sizeof(time_str), "%H:%M:%S", localtime(&sec));
+        snprintf(time_str + n, sizeof(time_str) - n, ".%03llu",
+                 (unsigned long long)(ts_ns / 1000000ULL % 1000));
+    }
+
+    uint32_t channel = *(uint32_t *)NLA_DATA(tb[CROWD_NL_ATTR_CHANNEL]);
+    uint32_t zone = tb[CROWD_NL_ATTR_ZONE] ? *(uint32_t *)NLA_DATA(tb[CROWD_NL_ATTR_ZONE]) : 0;
+    uint32_t occupancy = *(uint32_t *)NLA_DATA(tb[CROWD_NL_ATTR_OCCUPANCY]);
+    uint32_t threshold = tb[CROWD_NL_ATTR_THRESHOLD] ?
+                         *(uint32_t *)NLA_DATA(tb[CROWD_NL_ATTR_THRESHOLD]) : 0;
+    int vent = tb[CROWD_NL_ATTR_VENTILATION] && *(uint8_t *)NLA_DATA(tb[CROWD_NL_ATTR_VENTILATION]);
+
+    if (genl->cmd == CROWD_NL_CMD_CHANGE) {
+        int32_t delta = tb[CROWD_NL_ATTR_DELTA] ? *(int32_t *)NLA_DATA(tb[CROWD_NL_ATTR_DELTA]) : 0;
+        printf("[%s] 채널 %u (구역 %u): 인원 %u명 (%+d), 환기 %s\n",
+               time_str, channel, zone, occupancy, delta, vent ? "작동" : "중지");
+    } else {
+        uint32_t mode = tb[CROWD_NL_ATTR_MODE] ? *(uint32_t *)NLA_DATA(tb[CROWD_NL_ATTR_MODE]) : 0;
+        printf("채널 %u (구역 %u, %s): 인원 %u명, 임계값 %u명, 환기 %s\n",
+               channel, zone, mode == MODE_TRANSMITTER ? "송신" : "수신",
+               occupancy, threshold, vent ? "작동" : "중지");
+    }
+    fflush(stdout);
+}
+
+/*
+ * 응답/알림 수신. seq가 0이 아니면 그 요청의 끝(덤프의 NLMSG_DONE 또는 ACK/오류)에서 반환.
+ * 멀티캐스트 알림은 seq 0, portid 0으로 오므로 요청 응답과 섞여 와도 출력만 하고 넘어감.
+ * seq가 0이면 알림 대기: 요청에 속한 DONE/ERROR가 늦게 와도 무시하고 계속 수신.
+ */
+int receive_messages(int sock, uint16_t family_id, uint32_t seq) {
+    char buf[RECV_BUF_SIZE];
+
+    while (running) {
+        int len = recv(sock, buf, sizeof(buf), 0);
+        if (len < 0) {
+            if (errno == EINTR) continue;
+            if (errno == ENOBUFS) {
+                printf("알림 유실 (수신 버퍼 초과)\n");
+                continue;
+            }
+            perror("netlink 수신 실패");
+            return -1;
+        }
+
+        for (struct nlmsghdr *nlh = (struct nlmsghdr *)buf; NLMSG_OK(nlh, len);
+             nlh = NLMSG_NEXT(nlh, len)) {
+            int reply = seq && nlh->nlmsg_seq == seq && nlh->nlmsg_pid != 0;
+
+            if (nlh->nlmsg_type == family_id) {
+                print_state(nlh);
+                continue;
+            }
+            if (!reply) continue;
+
+            if (nlh->nlmsg_type == NLMSG_DONE) {
+                return 0;
+            }
+            if (nlh->nlmsg_type == NLMSG_ERROR) {
+                struct nlmsgerr *err = NLMSG_DATA(nlh);
+                if (err->error) {
+                    printf("요청 실패: %s\n", strerror(-err->error));
+                    return -1;
+                }
+                return 0;
+            }
+        }
+    }
+
+    return 0;
+}
+
+int main(int argc, char *argv[]) {
+    int dump_only = 0;
+    int channel = -1;
+
+    // 명령행 인수 처리
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "-d") == 0 || strcmp(argv[i], "--dump") == 0) {
+            dump_only = 1;
+        } else if ((strcmp(argv[i], "-c") == 0 || strcmp(argv[i], "--channel") == 0) && i + 1 < argc) {
+            channel = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "-h") == 0 || strcmp(argv[i], "--help") == 0) {
+            print_usage(argv[0]);
+            return 0;
+        } else {
+            print_usage(argv[0]);
+            return 1;
+        }
+    }
+
+    int sock = socket(AF_NETLINK, SOCK_RAW, NETLINK_GENERIC);
+    if (sock < 0) {
+        perror("netlink 소켓 생성 실패");
+        return 1;
+    }
+
+    uint16_t family_id;
+    uint32_t group_id;
+    if (resolve_family(sock, &family_id, &group_id) < 0) {
+        close(sock);
+        return 1;
+    }
+
+    char buf[256];
+    struct nlmsghdr *nlh;
+
+    if (channel >= 0) {
+        /* 채널 하나 조회 */
+        uint32_t value = channel;
+        nlh = init_request(buf, family_id, CROWD_NL_CMD_GET, NLM_F_ACK);
+        put_attr(nlh, CROWD_NL_ATTR_CHANNEL, &value, sizeof(value));
+        /* 응답 뒤에 오는 ACK까지 받고 반환 */
+        int ret = send_request(sock, nlh) < 0 || receive_messages(sock, family_id, nlh->nlmsg_seq) < 0;
+        close(sock);
+        return ret;
+    }
+
+    /* 구독 먼저 걸고 덤프 (덤프와 알림 사이의 변경을 놓치지 않도록) */
+    if (!dump_only &&
+        setsockopt(sock, SOL_NETLINK, NETLINK_ADD_MEMBERSHIP, &group_id, sizeof(group_id)) < 0) {
+        perror("멀티캐스트 그룹 가입 실패");
+        close(sock);
+        return 1;
+    }
+
+    printf("IoT 혼잡도 시스템 - netlink 모니터\n");
+    printf("=====================================\n");
+
+    nlh = init_request(buf, family_id, CROWD_NL_CMD_GET, NLM_F_DUMP);
+    if (send_request(sock, nlh) < 0 || receive_messages(sock, family_id, nlh->nlmsg_seq) < 0) {
+        close(sock);
+        return 1;
+    }
+
+    if (dump_only) {
+        close(sock);
+        return 0;
+    }
+
+    /* SA_RESTART 없이 등록해 블로킹 recv가 신호로 깨어나게 함 */
+    struct sigaction sa;
+    memset(&sa, 0, sizeof(sa));
+    sa.sa_handler = signal_handler;
+    sigaction(SIGINT, &sa, NULL);
+    sigaction(SIGTERM, &sa, NULL);
+
+    printf("\n변경 알림 대기 중... (Ctrl+C로 종료)\n");
+    receive_messages(sock, family_id, 0);
+
+    close(sock);
+    printf("\nnetlink 모니터 종료\n");
+    return 0;
+}
@@ -1,24 +1,88 @@
 #include <stdio.h>
 #include <stdlib.h>
+#include <stdint.h>
 #include <unistd.h>
 #include <fcntl.h>
 #include <string.h>
 #include <sys/ioctl.h>
+#include <sys/resource.h>
+#include <poll.h>
 #include <signal.h>
 #include <errno.h>
 #include <time.h>
+#include <dirent.h>
+#include <linux/gpio.h>
+
+#include "crowd_codec.h"
 
 #define DEVICE_PATH "/dev/crowd_gpio1"
 #define SYSFS_OCCUPANCY "/sys/class/crowd_monitor/crowd_gpio1/occupancy"
 #define SYSFS_THRESHOLD "/sys/class/crowd_monitor/crowd_gpio1/threshold"
+#define SYSFS_LINK_STATS "/sys/class/crowd_monitor/crowd_gpio1/link_stats"
+#define SYSFS_IRQ_STATS "/sys/class/crowd_monitor/crowd_gpio1/irq_stats"
 #define GPIO_IOCTL_SET_MODE _IOW('C', 1, int)
 #define MODE_RECEIVER 2
 #define DELAY_MS 500
 
-static int running = 1;
+/* 수신 깨우기 조절 (드라이버 struct crowd_coalesce와 동일) */
+struct crowd_coalesce {
+    uint32_t max_events;
+    uint32_t max_usecs;
+};
+#define GPIO_IOCTL_SET_COALESCE _IOW('C', 5, struct crowd_coalesce)
+#define GPIO_IOCTL_SET_EVENT_TS _IOW('C', 7, int)
+#define DEFAULT_BATCH_US 10000
+#define READ_BUF_SIZE (128 * 32 + 1)    /* 드라이버 최대 묶음 128개 × 가장 긴 줄 32바이트 */
+
+/* GPIO 문자 디바이스 (uAPI v2) 백엔드 기본값 */
+#define DEFAULT_CHIP "/dev/gpiochip0"
+#define DEFAULT_LINE 26
+#define DEFAULT_UNIT_US 1000
+/*
+ * 디바운스는 기본으로 끈다. bcm2835와 gpio-sim은 하드웨어 디바운스가 없어서
+ * gpiolib-cdev가 소프트웨어 디바운서(지피 단위 지연 워크)로 처리하는데,
+ * 이 경우 이벤트 시각이 에지가 아니라 워크 실행 시각이 되고 1~2단위 펄스는
+ * 사라지거나 폭이 최대 한 틱 어긋난다. 펄스 폭 판정이 깨지지 않도록 unit/4 미만만 허용.
+ */
+#define DEFAULT_DEBOUNCE_US 0
+#define EVENT_BATCH 64
+#define MAX_LATENCY_SAMPLES 100000
+
+static volatile sig_atomic_t running = 1;
+static int people_count = 0;
+static int threshold = 50;
+
+/* 벤치마크 통계 */
+struct bench_stats {
+    int enabled;
+    unsigned long events;
+    unsigned long edges;
+    unsigned long reads;
+    unsigned long dropped_edges;
+    unsigned long crc_errors;
+    unsigned long framing_errors;
+    unsigned long lost_frames;
+    uint64_t *latency_ns;
+    unsigned long latency_count;
+    double irq_thread_cpu_ms;       /* kernel: 수신 IRQ 스레드 (디코딩 + 이벤트 전달) */
+};
+
+/* kernel 백엔드 벤치마크 시작 시점의 드라이버 카운터 */
+struct kernel_snapshot {
+    unsigned long edges;
+    unsigned long edge_overruns;
+    unsigned long crc_errors;
+    unsigned long framing_errors;
+    unsigned long lost;
+    double irq_thread_cpu_ms;
+};
+
+static struct bench_stats bench;
 
 void signal_handler(int sig) {
-    printf("\n수신 프로그램을 종료합니다...\n");
+    if (!bench.enabled) {
+        printf("\n수신 프로그램을 종료합니다...\n");
+    }
     running = 0;
 }
 
@@ -42,14 +106,186 @@ int read_sysfs_int(const char *path) {
     return value;
 }
 
-int main() {
-    printf("IoT 혼잡도 시스템 - 수신 프로그램\n");
-    printf("하드웨어: GPIO 26 ← GPIO 17\n");
-    printf("=====================================\n");
+uint64_t now_ns(clockid_t clock) {
+    struct timespec ts;
+    clock_gettime(clock, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+void print_usage(const char *prog_name) {
+    printf("사용법: %s [옵션]\n", prog_name);
+    printf("옵션:\n");
+    printf("  -b, --backend kernel|uapi  수신 엔진 (기본 kernel)\n");
+    printf("                             kernel: /dev/crowd_gpio1 (crowd_driver 필요)\n");
+    printf("                             uapi:   GPIO 문자 디바이스에서 직접 에지 수신\n");
+    printf("  -c, --chip PATH            uapi: gpiochip 경로 (기본 %s)\n", DEFAULT_CHIP);
+    printf("  -l, --line N               uapi: 수신 라인 오프셋 (기본 %d)\n", DEFAULT_LINE);
+    printf("  -u, --unit-us N            uapi: 부호화 기본 단위 (드라이버 bit_unit_us, 기본 %d)\n",
+           DEFAULT_UNIT_US);
+    printf("  -d, --debounce-us N        uapi: 디바운스 (기본 %d: 끔, unit-us/4 미만만 허용,\n", DEFAULT_DEBOUNCE_US);
+    printf("                             하드웨어 디바운스가 없는 칩에서는 타임스탬프가 틱 단위로 밀림)\n");
+    printf("  -n, --batch N              kernel: 이벤트 N개가 쌓이면 깨움 (기본 1)\n");
+    printf("  -t, --batch-us N           kernel: 첫 이벤트 후 N us가 지나면 깨움 (--batch와 함께, 기본 %d)\n",
+           DEFAULT_BATCH_US);
+    printf("      --bench SEC            SEC초 동안 수신 후 처리량/CPU/지연 출력\n");
+    printf("  -h, --help                 도움말\n");
+}
+
+/* 수신 메시지 출력 및 인원 집계 */
+void handle_message(const char *buf, int sync_driver) {
+    char time_str[32];
+    
+    if (bench.enabled) {
+        bench.events++;
+        return;
+    }
+    
+    get_time_string(time_str, sizeof(time_str));
+    
+    if (strncmp(buf, "ENTER", 5) == 0) {
+        people_count++;
+        printf("[%s] 🚪 입장 감지 - 현재 %d명", time_str, people_count);
+    
+        if (people_count >= threshold) {
+            printf(" ⚠️ 환기 필요!");
+        }
+        printf("\n");
+    
+    } else if (strncmp(buf, "EXIT", 4) == 0) {
+        if (people_count > 0) people_count--;
+        printf("[%s] 🚪 퇴장 감지 - 현재 %d명\n", time_str, people_count);
+    
+    } else if (strncmp(buf, "STATUS", 6) == 0) {
+        printf("[%s] 📊 상태 조회 - 현재 %d명 (임계값: %d명)\n",
+               time_str, people_count, threshold);
+    
+    } else {
+        printf("[%s] ❓ 알 수 없는 신호: %s\n", time_str, buf);
+    }
+    
+    if (!sync_driver) {
+        return;
+    }
+    
+    // sysfs에서 실제 값 읽기 (드라이버 상태와 동기화)
+    int actual_count = read_sysfs_int(SYSFS_OCCUPANCY);
+    if (actual_count >= 0 && actual_count != people_count) {
+        printf("    (드라이버 상태: %d명)\n", actual_count);
+        people_count = actual_count;  // 동기화
+    }
+}
+
+/* ========== 커널 모듈 백엔드 ========== */
+
+/* "key: value" 형식 sysfs 파일에서 값 하나 읽기 (없으면 0) */
+unsigned long read_sysfs_stat(const char *path, const char *key) {
+    FILE *file = fopen(path, "r");
+    char line[128];
+    size_t key_len = strlen(key);
+    unsigned long value = 0;
+    
+    if (!file) return 0;
+    
+    while (fgets(line, sizeof(line), file)) {
+        if (strncmp(line, key, key_len) == 0 && line[key_len] == ':') {
+            value = strtoul(line + key_len + 1, NULL, 10);
+            break;
+        }
+    }
+    fclose(file);
+    return value;
+}
+
+/* irq_stats의 "data: irq N edges M ..." 줄 */
+int read_data_irq(unsigned long *edges) {
+    FILE *file = fopen(SYSFS_IRQ_STATS, "r");
+    char line[256];
+    int irq = -1;
+    
+    *edges = 0;
+    if (!file) return -1;
+    
+    while (fgets(line, sizeof(line), file)) {
+        if (sscanf(line, "data: irq %d edges %lu", &irq, edges) == 2) break;
+    }
+    fclose(file);
+    return irq;
+}
+
+/* 수신 IRQ 스레드 (irq/N-crowd_gpio_irq) 의 누적 CPU 시간 (ms, 찾지 못하면 0) */
+double read_irq_thread_cpu_ms(int irq) {
+    char prefix[32], path[300], comm[64];
+    struct dirent *ent;
+    double cpu_ms = 0;
+    DIR *proc;
+    
+    if (irq < 0) return 0;
+    snprintf(prefix, sizeof(prefix), "irq/%d-", irq);
+    
+    proc = opendir("/proc");
+    if (!proc) return 0;
+    
+    while ((ent = readdir(proc)) != NULL) {
+        if (ent->d_name[0] < '0' || ent->d_name[0] > '9') continue;
+    
+        snprintf(path, sizeof(path), "/proc/%s/comm", ent->d_name);
+        FILE *file = fopen(path, "r");
+        if (!file) continue;
+        int match = fgets(comm, sizeof(comm), file) && strncmp(comm, prefix, strlen(prefix)) == 0;
+        fclose(file);
+        if (!match) continue;
+    
+        /* /proc/PID/stat의 14, 15번째 필드: utime, stime (클록 틱) */
+        snprintf(path, sizeof(path), "/proc/%s/stat", ent->d_name);
+        file = fopen(path, "r");
+        if (!file) continue;
+        unsigned long utime, stime;
+        if (fscanf(file, "%*d (%*[^)]) %*c %*d %*d %*d %*d %*d %*u %*u %*u %*u %*u %lu %lu",
+                   &utime, &stime) == 2) {
+            cpu_ms = (utime + stime) * 1000.0 / sysconf(_SC_CLK_TCK);
+        }
+        fclose(file);
+        break;
+    }
+    closedir(proc);
+    return cpu_ms;
+}
+
+void kernel_snapshot(struct kernel_snapshot *snap) {
+    int irq = read_data_irq(&snap->edges);
+    
+    snap->edge_overruns = read_sysfs_stat(SYSFS_LINK_STATS, "edge_overruns");
+    snap->crc_errors = read_sysfs_stat(SYSFS_LINK_STATS, "crc_errors");
+    snap->framing_errors = read_sysfs_stat(SYSFS_LINK_STATS, "framing_errors");
+    snap->lost = read_sysfs_stat(SYSFS_LINK_STATS, "lost");
+    snap->irq_thread_cpu_ms = read_irq_thread_cpu_ms(irq);
+}
+
+/* 벤치마크 구간 동안의 드라이버 카운터 변화를 uapi 백엔드와 같은 항목으로 */
+void kernel_bench_delta(const struct kernel_snapshot *start) {
+    struct kernel_snapshot end;
     
-    signal(SIGINT, signal_handler);
+    kernel_snapshot(&end);
+    bench.edges = end.edges - start->edges;
+    bench.dropped_edges = end.edge_overruns - start->edge_overruns;
+    bench.crc_errors = end.crc_errors - start->crc_errors;
+    bench.framing_errors = end.framing_errors - start->framing_errors;
+    bench.lost_frames = end.lost - start->lost;
+    bench.irq_thread_cpu_ms = end.irq_thread_cpu_ms - start->irq_thread_cpu_ms;
+}
+
+/* 벤치마크 모드 줄 형식 "TYPE <ns>": ns는 드라이버가 찍은 프레임 마지막 에지 시각 */
+void record_kernel_latency(const char *msg) {
+    const char *ts = strchr(msg, ' ');
     
-    int fd = open(DEVICE_PATH, O_RDONLY | O_NONBLOCK);
+    if (!ts || bench.latency_count >= MAX_LATENCY_SAMPLES) return;
+    bench.latency_ns[bench.latency_count++] = now_ns(CLOCK_MONOTONIC) - strtoull(ts + 1, NULL, 10);
+}
+
+int run_kernel_backend(const struct crowd_coalesce *coalesce) {
+    /* 벤치마크/묶음 수신은 블로킹 read로 깨우기 조건이 될 때 깨어남 (신호로 중단) */
+    int blocking = bench.enabled || coalesce->max_events > 1;
+    int fd = open(DEVICE_PATH, blocking ? O_RDONLY : O_RDONLY | O_NONBLOCK);
     if (fd < 0) {
         perror("디바이스 열기 실패");
         printf("해결 방법:\n");
@@ -58,65 +294,51 @@ int main() {
         return 1;
     }
     
-    // 수신 모드로 설정
-    if (ioctl(fd, GPIO_IOCTL_SET_MODE, MODE_RECEIVER) < 0) {
+    // 수신 모드로 설정 (드라이버는 int 포인터를 받음)
+    int mode = MODE_RECEIVER;
+    if (ioctl(fd, GPIO_IOCTL_SET_MODE, &mode) < 0) {
         perror("수신 모드 설정 실패");
         close(fd);
         return 1;
     }
     
-    printf("신호 수신 대기 중... (Ctrl+C로 종료)\n");
-    printf("===================================\n");
+    if (coalesce->max_events > 1 && ioctl(fd, GPIO_IOCTL_SET_COALESCE, coalesce) < 0) {
+        perror("깨우기 조절 설정 실패");
+        close(fd);
+        return 1;
+    }
+    
+    /* 벤치마크: uapi 백엔드와 같은 기준(마지막 에지 → 사용자 공간)으로 지연 측정 */
+    int on = 1;
+    if (bench.enabled && ioctl(fd, GPIO_IOCTL_SET_EVENT_TS, &on) < 0) {
+        perror("이벤트 타임스탬프 설정 실패 (지연 측정 생략)");
+    }
+    
+    struct kernel_snapshot snap;
+    if (bench.enabled) kernel_snapshot(&snap);
     
-    char prev_msg[64] = "";
-    int people_count = 0;
-    int threshold = read_sysfs_int(SYSFS_THRESHOLD);
-    if (threshold < 0) threshold = 50;  // 기본값
+    int value = read_sysfs_int(SYSFS_THRESHOLD);
+    if (value > 0) threshold = value;
     
-    printf("현재 임계값: %d명\n\n", threshold);
+    if (!bench.enabled) {
+        printf("신호 수신 대기 중... (Ctrl+C로 종료)\n");
+        printf("===================================\n");
+        printf("현재 임계값: %d명\n\n", threshold);
+    }
     
     while (running) {
-        char buf[256] = {0};
-        char time_str[32];
+        char buf[READ_BUF_SIZE] = {0};
         
         ssize_t n = read(fd, buf, sizeof(buf) - 1);
         
         if (n > 0) {
             buf[n] = '\0';
-            buf[strcspn(buf, "\n")] = 0;  // 개행 제거
+            bench.reads++;
             
-            if (strlen(buf) > 0 && strcmp(buf, prev_msg) != 0) {
-                get_time_string(time_str, sizeof(time_str));
-                
-                if (strncmp(buf, "ENTER", 5) == 0) {
-                    people_count++;
-                    printf("[%s] 🚪 입장 감지 - 현재 %d명", time_str, people_count);
-                    
-                    if (people_count >= threshold) {
-                        printf(" ⚠️ 환기 필요!");
-                    }
-                    printf("\n");
-                    
-                } else if (strncmp(buf, "EXIT", 4) == 0) {
-                    if (people_count > 0) people_count--;
-                    printf("[%s] 🚪 퇴장 감지 - 현재 %d명\n", time_str, people_count);
-                    
-                } else if (strncmp(buf, "STATUS", 6) == 0) {
-                    printf("[%s] 📊 상태 조회 - 현재 %d명 (임계값: %d명)\n", 
-                           time_str, people_count, threshold);
-                    
-                } else {
-                    printf("[%s] ❓ 알 수 없는 신호: %s\n", time_str, buf);
-                }
-                
-                // sysfs에서 실제 값 읽기 (드라이버 상태와 동기화)
-                int actual_count = read_sysfs_int(SYSFS_OCCUPANCY);
-                if (actual_count >= 0 && actual_count != people_count) {
-                    printf("    (드라이버 상태: %d명)\n", actual_count);
-                    people_count = actual_count;  // 동기화
-                }
-                
-                strcpy(prev_msg, buf);
+            // 한 번의 read에 여러 이벤트가 줄 단위로 들어옴
+            for (char *msg = strtok(buf, "\n"); msg; msg = strtok(NULL, "\n")) {
+                if (bench.enabled) record_kernel_latency(msg);
+                handle_message(msg, 1);
             }
         } else if (n < 0 && errno != EAGAIN && errno != EWOULDBLOCK) {
             if (errno != EINTR) {  // SIGINT는 정상
@@ -124,10 +346,283 @@ int main() {
             }
         }
         
-        usleep(DELAY_MS * 1000);
+        if (!blocking) {
+            usleep(DELAY_MS * 1000);
+        }
     }
     
+    if (bench.enabled) kernel_bench_delta(&snap);
+    
     close(fd);
-    printf("수신 프로그램 종료 (최종 인원: %d명)\n", people_count);
     return 0;
+}
+
+/* ========== GPIO 문자 디바이스 v2 백엔드 ========== */
+
+int request_rx_line(int chip_fd, int line, int debounce_us, uint64_t clock_flag) {
+    struct gpio_v2_line_request req;
+    
+    memset(&req, 0, sizeof(req));
+    req.offsets[0] = line;
+    req.num_lines = 1;
+    req.event_buffer_size = 1024;
+    strncpy(req.consumer, "crowd_rx", sizeof(req.consumer) - 1);
+    req.config.flags = GPIO_V2_LINE_FLAG_INPUT |
+                       GPIO_V2_LINE_FLAG_EDGE_RISING |
+                       GPIO_V2_LINE_FLAG_EDGE_FALLING | clock_flag;
+    
+    if (debounce_us > 0) {
+        req.config.num_attrs = 1;
+        req.config.attrs[0].attr.id = GPIO_V2_LINE_ATTR_ID_DEBOUNCE;
+        req.config.attrs[0].attr.debounce_period_us = debounce_us;
+        req.config.attrs[0].mask = 1;
+    }
+    
+    if (ioctl(chip_fd, GPIO_V2_GET_LINE_IOCTL, &req) < 0) {
+        return -1;
+    }
+    return req.fd;
+}
+
+int run_uapi_backend(const char *chip, int line, int unit_us, int debounce_us) {
+    int chip_fd = open(chip, O_RDONLY);
+    if (chip_fd < 0) {
+        perror("gpiochip 열기 실패");
+        return 1;
+    }
+    
+    /* 하드웨어 타임스탬프(HTE)를 우선 시도하고, 없으면 커널 monotonic 시각 사용 */
+    int hte = 1;
+    int line_fd = request_rx_line(chip_fd, line, debounce_us, GPIO_V2_LINE_FLAG_EVENT_CLOCK_HTE);
+    if (line_fd < 0) {
+        hte = 0;
+        line_fd = request_rx_line(chip_fd, line, debounce_us, 0);
+    }
+    close(chip_fd);
+    
+    if (line_fd < 0) {
+        perror("라인 요청 실패");
+        printf("crowd_driver가 같은 라인을 잡고 있다면 먼저 언로드하세요: sudo make unload\n");
+        return 1;
+    }
+    
+    if (!bench.enabled) {
+        printf("uAPI 백엔드: %s 라인 %d (타임스탬프: %s, 디바운스 %dus)\n",
+               chip, line, hte ? "HTE" : "monotonic", debounce_us);
+        printf("신호 수신 대기 중... (Ctrl+C로 종료)\n");
+        printf("===================================\n");
+    }
+    
+    struct gpio_v2_line_event events[EVENT_BATCH];
+    struct crowd_decoder dec = {0};
+    uint64_t unit_ns = (uint64_t)unit_us * 1000;
+    uint32_t last_seqno = 0;
+    int expected_seq = -1;
+    
+    while (running) {
+        struct pollfd pfd = { .fd = line_fd, .events = POLLIN };
+    
+        int ret = poll(&pfd, 1, 200);
+        if (ret <= 0) {
+            if (ret < 0 && errno != EINTR) perror("poll 오류");
+            continue;
+        }
+    
+        /* 에지 이벤트를 한 번의 read로 묶어서 읽음 */
+        ssize_t n = read(line_fd, events, sizeof(events));
+        if (n < 0) {
+            if (errno != EINTR && errno != EAGAIN) perror("이벤트 읽기 오류");
+            continue;
+        }
+        bench.reads++;
+    
+        int count = n / sizeof(events[0]);
+        for (int i = 0; i < count; i++) {
+            struct gpio_v2_line_event *ev = &events[i];
+            uint32_t word;
+    
+            /* 커널 이벤트 버퍼가 넘치면 seqno가 건너뜀 */
+            if (last_seqno && ev->line_seqno != last_seqno + 1) {
+                bench.dropped_edges += ev->line_seqno - last_seqno - 1;
+            }
+            last_seqno = ev->line_seqno;
+            bench.edges++;
+    
+            int level = ev->id == GPIO_V2_LINE_EVENT_RISING_EDGE;
+            int res = crowd_decoder_feed(&dec, level, ev->timestamp_ns, unit_ns, 0, &word);
+            if (res < 0) {
+                bench.framing_errors++;
+                continue;
+            }
+            if (res == 0) continue;
+    
+            struct crowd_frame frame;
+            if (crowd_frame_unpack(word, &frame) < 0) {
+                bench.crc_errors++;
+                continue;
+            }
+            int type = frame.type;
+            int seq = frame.seq;
+            if (type < CROWD_FRAME_ENTER || type > CROWD_FRAME_STATUS) continue;
+    
+            if (expected_seq >= 0) {
+                bench.lost_frames += (seq - expected_seq) & (CROWD_SEQ_SPACE - 1);
+            }
+            expected_seq = (seq + 1) % CROWD_SEQ_SPACE;
+    
+            /* 프레임 마지막 에지부터 사용자 공간 처리까지의 지연 */
+            if (bench.enabled && !hte && bench.latency_count < MAX_LATENCY_SAMPLES) {
+                bench.latency_ns[bench.latency_count++] = now_ns(CLOCK_MONOTONIC) - ev->timestamp_ns;
+            }
+    
+            handle_message(type == CROWD_FRAME_ENTER ? "ENTER" : type == CROWD_FRAME_EXIT ? "EXIT" : "STATUS", 0);
+        }
+    }
+    
+    close(line_fd);
+    return 0;
+}
+
+/* ========== 벤치마크 ========== */
+
+int compare_u64(const void *a, const void *b) {
+    uint64_t x = *(const uint64_t *)a, y = *(const uint64_t *)b;
+    return (x > y) - (x < y);
+}
+
+void bench_report(const char *backend, double elapsed_s) {
+    struct rusage ru;
+    getrusage(RUSAGE_SELF, &ru);
+    double cpu_ms = ru.ru_utime.tv_sec * 1e3 + ru.ru_utime.tv_usec / 1e3 +
+                    ru.ru_stime.tv_sec * 1e3 + ru.ru_stime.tv_usec / 1e3;
+    
+    printf("=== 수신 벤치마크 (%s) ===\n", backend);
+    printf("측정 시간: %.1f초\n", elapsed_s);
+    printf("이벤트: %lu개 (%.1f/s)\n", bench.events, bench.events / elapsed_s);
+    printf("read 호출: %lu회\n", bench.reads);
+    printf("프로세스 CPU: %.1f ms (이벤트당 %.3f ms)\n",
+           cpu_ms, bench.events ? cpu_ms / bench.events : 0.0);
+    
+    /* 커널 경로는 디코딩과 이벤트 전달이 IRQ 스레드에서 돌므로 함께 집계 */
+    if (strcmp(backend, "kernel") == 0) {
+        double total_ms = cpu_ms + bench.irq_thread_cpu_ms;
+    
+        printf("IRQ 스레드 CPU: %.1f ms, 합계 %.1f ms (이벤트당 %.3f ms)\n",
+               bench.irq_thread_cpu_ms, total_ms, bench.events ? total_ms / bench.events : 0.0);
+    }
+    
+    printf("에지: %lu개 (유실 %lu), CRC 오류 %lu, 프레이밍 오류 %lu, 프레임 손실 %lu\n",
+           bench.edges, bench.dropped_edges, bench.crc_errors,
+           bench.framing_errors, bench.lost_frames);
+    
+    if (bench.latency_count > 0) {
+        qsort(bench.latency_ns, bench.latency_count, sizeof(uint64_t), compare_u64);
+        printf("전달 지연 (마지막 에지 → 사용자 공간): p50 %.1f us, p99 %.1f us, max %.1f us\n",
+               bench.latency_ns[bench.latency_count / 2] / 1e3,
+               bench.latency_ns[bench.latency_count * 99 / 100] / 1e3,
+               bench.latency_ns[bench.latency_count - 1] / 1e3);
+    }
+}
+
+int main(int argc, char *argv[]) {
+    const char *backend = "kernel";
+    const char *chip = DEFAULT_CHIP;
+    int line = DEFAULT_LINE;
+    int unit_us = DEFAULT_UNIT_US;
+    int debounce_us = DEFAULT_DEBOUNCE_US;
+    int bench_sec = 0;
+    struct crowd_coalesce coalesce = { .max_events = 1, .max_usecs = 0 };
+    
+    // 명령행 인수 처리
+    for (int i = 1; i < argc; i++) {
+        const char *arg = argv[i];
+        const char *val = (i + 1 < argc) ? argv[i + 1] : NULL;
+    
+        if ((strcmp(arg, "-b") == 0 || strcmp(arg, "--backend") == 0) && val) {
+            backend = val; i++;
+        } else if ((strcmp(arg, "-c") == 0 || strcmp(arg, "--chip") == 0) && val) {
+            chip = val; i++;
+        } else if ((strcmp(arg, "-l") == 0 || strcmp(arg, "--line") == 0) && val) {
+            line = atoi(val); i++;
+        } else if ((strcmp(arg, "-u") == 0 || strcmp(arg, "--unit-us") == 0) && val) {
+            unit_us = atoi(val); i++;
+        } else if ((strcmp(arg, "-d") == 0 || strcmp(arg, "--debounce-us") == 0) && val) {
+            debounce_us = atoi(val); i++;
+        } else if ((strcmp(arg, "-n") == 0 || strcmp(arg, "--batch") == 0) && val) {
+            coalesce.max_events = atoi(val); i++;
+        } else if ((strcmp(arg, "-t") == 0 || strcmp(arg, "--batch-us") == 0) && val) {
+            coalesce.max_usecs = atoi(val); i++;
+        } else if (strcmp(arg, "--bench") == 0 && val) {
+            bench_sec = atoi(val); i++;
+        } else if (strcmp(arg, "-h") == 0 || strcmp(arg, "--help") == 0) {
+            print_usage(argv[0]);
+            return 0;
+        } else {
+            print_usage(argv[0]);
+            return 1;
+        }
+    }
+    
+    if (strcmp(backend, "kernel") != 0 && strcmp(backend, "uapi") != 0) {
+        printf("알 수 없는 백엔드: %s\n", backend);
+        return 1;
+    }
+    
+    if (coalesce.max_events > 1 && coalesce.max_usecs == 0) {
+        coalesce.max_usecs = DEFAULT_BATCH_US;
+    }
+    
+    if (unit_us <= 0) {
+        printf("잘못된 단위: %d\n", unit_us);
+        return 1;
+    }
+    
+    if (debounce_us < 0 || debounce_us >= unit_us / 4) {
+        printf("디바운스 %dus는 펄스 폭 판정을 깨뜨림 (unit-us/4 = %dus 미만)\n", debounce_us, unit_us / 4);
+        return 1;
+    }
+    
+    printf("IoT 혼잡도 시스템 - 수신 프로그램\n");
+    printf("하드웨어: GPIO 26 ← GPIO 17 (백엔드: %s)\n", backend);
+    printf("=====================================\n");
+    
+    /* SA_RESTART 없이 등록해 블로킹 read/poll이 신호로 깨어나게 함 */
+    struct sigaction sa;
+    memset(&sa, 0, sizeof(sa));
+    sa.sa_handler = signal_handler;
+    sigaction(SIGINT, &sa, NULL);
+    sigaction(SIGALRM, &sa, NULL);
+    
+    if (bench_sec > 0) {
+        bench.enabled = 1;
+        bench.latency_ns = calloc(MAX_LATENCY_SAMPLES, sizeof(uint64_t));
+        if (!bench.latency_ns) {
+            perror("메모리 할당 실패");
+            return 1;
+        }
+        printf("벤치마크: %d초 동안 수신\n", bench_sec);
+        alarm(bench_sec);
+    }
+    
+    uint64_t start = now_ns(CLOCK_MONOTONIC);
+    int ret;
+    
+    if (strcmp(backend, "uapi") == 0) {
+        ret = run_uapi_backend(chip, line, unit_us, debounce_us);
+    } else {
+        ret = run_kernel_backend(&coalesce);
+    }
+    
+    if (bench.enabled) {
+        if (ret == 0) {
+            bench_report(backend, (now_ns(CLOCK_MONOTONIC) - start) / 1e9);
+        }
+        free(bench.latency_ns);
+        return ret;
+    }
+    
+    if (ret == 0) {
+        printf("수신 프로그램 종료 (최종 인원: %d명)\n", people_count);
+    }
+    return ret;
 }
\ No newline at end of file
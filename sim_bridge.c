@@ -0,0 +1,401 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <string.h>
+#include <signal.h>
+#include <errno.h>
+#include <time.h>
+#include <sys/ioctl.h>
+#include <linux/gpio.h>
+
+#include "crowd_codec.h"
+
+/*
+ * gpio-sim 루프백 브리지
+ * 시뮬레이터 라인 src에 드라이버가 출력한 값을 라인 dst의 pull로 복사해
+ * GPIO 17 → 26 배선을 흉내낸다. (dst 라인에 에지 인터럽트가 발생함)
+ *
+ * 공유선 (오픈 드레인, src+src:dst 또는 --peer): 풀업된 선 하나에 여러 송신기를 wire-AND.
+ *   출력 방향이고 LOW인 src가 하나라도 있으면 선이 LOW. 선을 놓은(입력) src는 자기 pull로
+ *   선 상태를 읽으므로, src마다 pull을 "다른 송신기가 끌어내리는 중인가"로 맞춘다.
+ *   방향은 gpiochip 문자 디바이스의 라인 정보로 읽는다 (값만으로는 놓은 선과 구분 불가).
+ * --peer NODE: 브리지 안의 가상 송신기가 노드 ID NODE로 첫 그룹 공유선에 프레임을 보냄
+ *   (드라이버와 같은 listen-before-talk / 충돌 감지 / 이진 지수 백오프, 재전송 없음)
+ *
+ * 사용법: crowd_sim_bridge [옵션] <gpio-sim 디바이스> <gpiochip 이름> src[+src...]:dst ...
+ *   예) crowd_sim_bridge gpio-sim.0 gpiochip2 0:1 2:3
+ *       crowd_sim_bridge --peer 2 --unit-us 2000 gpio-sim.0 gpiochip2 0:1
+ */
+
+#define SIM_SYSFS_FMT "/sys/devices/platform/%s/%s/sim_gpio%d/%s"
+#define MAX_PAIRS 16
+#define MAX_SRCS 4
+#define POLL_US 20
+
+/* 드라이버 gpio_drv.c와 같은 공유선 매개변수 */
+#define LBT_IDLE_UNITS 4
+#define BACKOFF_SLOT_UNITS 8
+#define BACKOFF_MAX_EXP 6
+#define TX_MAX_ATTEMPTS 10
+
+enum {
+    PEER_WAIT,      /* 다음 프레임 / 백오프 대기 */
+    PEER_LBT,       /* 선이 LBT_IDLE_UNITS 동안 비어 있는지 확인 */
+    PEER_HIGH,      /* 펄스 (선 끌어내림) */
+    PEER_LOW,       /* 펄스 사이 (놓고 충돌 감시) */
+    PEER_IFG,
+    PEER_DONE,
+};
+
+/* 브리지 안의 가상 송신 노드 */
+struct sim_peer {
+    int node;
+    long frames_left;
+    uint64_t unit_ns;
+    uint64_t interval_ns;
+    int state;
+    int attempt;
+    uint64_t until_ns;
+    uint8_t seq;
+    struct crowd_pulse pulses[CROWD_MAX_PULSES];
+    int npulses;
+    int idx;
+    unsigned long sent, collisions, lbt_busy, backoffs, aborts;
+};
+
+struct bridge_pair {
+    int src[MAX_SRCS];
+    int nsrc;
+    int dst;
+    int value_fd[MAX_SRCS];
+    int src_pull_fd[MAX_SRCS];  /* 공유선: 선을 놓은 src가 읽을 값 */
+    char src_pull[MAX_SRCS];
+    int pull_fd;
+    char last;
+    int open_drain;
+    struct sim_peer *peer;
+};
+
+static int running = 1;
+
+void signal_handler(int sig) {
+    running = 0;
+}
+
+uint64_t now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+void print_usage(const char *prog_name) {
+    printf("사용법: %s [옵션] <gpio-sim 디바이스> <gpiochip 이름> src[+src...]:dst ...\n", prog_name);
+    printf("옵션:\n");
+    printf("  --peer NODE       첫 그룹 공유선에 가상 송신기 추가 (노드 ID NODE)\n");
+    printf("  --peer-frames N   가상 송신기 프레임 수 (기본 200, 0: 무한)\n");
+    printf("  --peer-ms MS      가상 송신기 프레임 간격 (기본 0: 링크 최대 속도)\n");
+    printf("  --unit-us US      선로 부호 단위 (드라이버 bit_unit_us, 기본 2000)\n");
+}
+
+int open_sim_attr(const char *dev_name, const char *chip_name, int line,
+                  const char *attr, int flags) {
+    char path[256];
+
+    snprintf(path, sizeof(path), SIM_SYSFS_FMT, dev_name, chip_name, line, attr);
+    int fd = open(path, flags);
+    if (fd < 0) {
+        fprintf(stderr, "%s: %s\n", path, strerror(errno));
+    }
+    return fd;
+}
+
+int set_pull(int fd, char value) {
+    const char *pull = (value == '1') ? "pull-up" : "pull-down";
+    if (pwrite(fd, pull, strlen(pull), 0) < 0) {
+        perror("pull 설정 실패");
+        return -1;
+    }
+    return 0;
+}
+
+/* 드라이버가 이 라인을 출력으로 두고 LOW로 끌어내리는 중인지 */
+int src_pulling_low(int chip_fd, const struct bridge_pair *p, int i) {
+    struct gpio_v2_line_info info;
+    char c;
+
+    memset(&info, 0, sizeof(info));
+    info.offset = p->src[i];
+    if (ioctl(chip_fd, GPIO_V2_GET_LINEINFO_IOCTL, &info) < 0 ||
+        !(info.flags & GPIO_V2_LINE_FLAG_OUTPUT)) {
+        return 0;
+    }
+    return pread(p->value_fd[i], &c, 1, 0) == 1 && c == '0';
+}
+
+/* ========== 가상 송신 노드 ========== */
+
+void peer_backoff(struct sim_peer *peer, uint64_t now) {
+    if (++peer->attempt >= TX_MAX_ATTEMPTS) {
+        /* 드라이버와 같이 포기 (재전송이 없으므로 다음 시퀀스로) */
+        peer->aborts++;
+        peer->attempt = 0;
+        peer->seq = (peer->seq + 1) % CROWD_SEQ_SPACE;
+        peer->until_ns = now + peer->interval_ns;
+    } else {
+        int exp = peer->attempt < BACKOFF_MAX_EXP ? peer->attempt : BACKOFF_MAX_EXP;
+        peer->backoffs++;
+        peer->until_ns = now + (uint64_t)(rand() % (1 << exp)) * BACKOFF_SLOT_UNITS * peer->unit_ns;
+    }
+    peer->state = PEER_WAIT;
+}
+
+/* 한 폴링 주기만큼 진행. other_low: 다른 송신기가 선을 끌어내리는 중. 반환값: 가상 노드가 끌어내리는 중 */
+int peer_step(struct sim_peer *peer, int other_low, uint64_t now) {
+    switch (peer->state) {
+    case PEER_WAIT:
+        if (now < peer->until_ns) return 0;
+        if (peer->frames_left == 0) {
+            peer->state = PEER_DONE;
+            return 0;
+        }
+        peer->state = PEER_LBT;
+        peer->until_ns = now + LBT_IDLE_UNITS * peer->unit_ns;
+        return 0;
+
+    case PEER_LBT:
+        if (other_low) {
+            peer->lbt_busy++;
+            peer_backoff(peer, now);
+            return 0;
+        }
+        if (now < peer->until_ns) return 0;
+
+        /* 입장/퇴장 번갈아 (수신측 인원이 한쪽으로 쌓이지 않게) */
+        struct crowd_frame frame = {
+            .type = peer->sent % 2 ? CROWD_FRAME_EXIT : CROWD_FRAME_ENTER,
+            .seq = peer->seq,
+            .node = peer->node,
+        };
+        peer->npulses = crowd_encode_word(crowd_frame_pack(&frame), 0, peer->pulses);
+        peer->idx = 0;
+        peer->state = PEER_HIGH;
+        peer->until_ns = now + peer->pulses[0].high_units * peer->unit_ns;
+        return 1;
+
+    case PEER_HIGH:
+        if (now < peer->until_ns) return 1;
+        peer->state = PEER_LOW;
+        peer->until_ns = now + peer->unit_ns;
+        return 0;
+
+    case PEER_LOW:
+        /* 놓았는데 LOW면 다른 송신기와 충돌: 바로 멈추고 백오프 */
+        if (other_low) {
+            peer->collisions++;
+            peer_backoff(peer, now);
+            return 0;
+        }
+        if (now < peer->until_ns) return 0;
+        if (++peer->idx == peer->npulses) {
+            peer->state = PEER_IFG;
+            peer->until_ns = now + CROWD_IFG_UNITS * peer->unit_ns;
+            return 0;
+        }
+        peer->state = PEER_HIGH;
+        peer->until_ns = now + peer->pulses[peer->idx].high_units * peer->unit_ns;
+        return 1;
+
+    case PEER_IFG:
+        if (now < peer->until_ns) return 0;
+        peer->sent++;
+        peer->attempt = 0;
+        peer->seq = (peer->seq + 1) % CROWD_SEQ_SPACE;
+        if (peer->frames_left > 0) peer->frames_left--;
+        peer->state = PEER_WAIT;
+        peer->until_ns = now + peer->interval_ns;
+        return 0;
+    }
+
+    return 0;
+}
+
+/* ========== 공유선 ========== */
+
+void bridge_open_drain(int chip_fd, struct bridge_pair *p, uint64_t now) {
+    int pulling[MAX_SRCS];
+    int low_count = 0;
+    int peer_low = 0;
+
+    for (int i = 0; i < p->nsrc; i++) {
+        pulling[i] = src_pulling_low(chip_fd, p, i);
+        low_count += pulling[i];
+    }
+    if (p->peer) {
+        peer_low = peer_step(p->peer, low_count > 0, now);
+    }
+
+    /* 놓은 src는 다른 송신기만 보고, 끌어내리는 src는 놓는 순간 읽을 값을 미리 맞춰 둠 */
+    for (int i = 0; i < p->nsrc; i++) {
+        char c = (low_count - pulling[i] > 0 || peer_low) ? '0' : '1';
+        if (c != p->src_pull[i] && set_pull(p->src_pull_fd[i], c) == 0) {
+            p->src_pull[i] = c;
+        }
+    }
+
+    char c = (low_count > 0 || peer_low) ? '0' : '1';
+    if (c != p->last && set_pull(p->pull_fd, c) == 0) {
+        p->last = c;
+    }
+}
+
+int parse_group(const char *arg, struct bridge_pair *p) {
+    char buf[64];
+    char *colon;
+
+    snprintf(buf, sizeof(buf), "%s", arg);
+    colon = strchr(buf, ':');
+    if (!colon || sscanf(colon + 1, "%d", &p->dst) != 1) return -1;
+    *colon = '\0';
+
+    p->nsrc = 0;
+    for (char *tok = strtok(buf, "+"); tok; tok = strtok(NULL, "+")) {
+        if (p->nsrc == MAX_SRCS || sscanf(tok, "%d", &p->src[p->nsrc]) != 1) return -1;
+        p->nsrc++;
+    }
+    if (p->nsrc == 0) return -1;
+
+    p->open_drain = p->nsrc > 1;
+    return 0;
+}
+
+int main(int argc, char *argv[]) {
+    struct bridge_pair pairs[MAX_PAIRS];
+    struct sim_peer peer = { .node = -1, .frames_left = 200, .unit_ns = 2000000ULL };
+    int npairs = 0;
+    int argi = 1;
+
+    // 명령행 인수 처리 (옵션 뒤에 디바이스/칩/라인 그룹)
+    for (; argi < argc && strncmp(argv[argi], "--", 2) == 0; argi++) {
+        const char *val = (argi + 1 < argc) ? argv[argi + 1] : NULL;
+
+        if (strcmp(argv[argi], "--peer") == 0 && val) {
+            peer.node = atoi(val); argi++;
+        } else if (strcmp(argv[argi], "--peer-frames") == 0 && val) {
+            peer.frames_left = atol(val); argi++;
+            if (peer.frames_left == 0) peer.frames_left = -1;
+        } else if (strcmp(argv[argi], "--peer-ms") == 0 && val) {
+            peer.interval_ns = (uint64_t)atoi(val) * 1000000ULL; argi++;
+        } else if (strcmp(argv[argi], "--unit-us") == 0 && val) {
+            peer.unit_ns = (uint64_t)atoi(val) * 1000ULL; argi++;
+        } else {
+            print_usage(argv[0]);
+            return 1;
+        }
+    }
+
+    if (argc - argi < 3 || peer.node > 255 || peer.unit_ns == 0) {
+        print_usage(argv[0]);
+        return 1;
+    }
+    const char *dev_name = argv[argi];
+    const char *chip_name = argv[argi + 1];
+
+    for (int i = argi + 2; i < argc && npairs < MAX_PAIRS; i++) {
+        struct bridge_pair *p = &pairs[npairs];
+
+        memset(p, 0, sizeof(*p));
+        if (parse_group(argv[i], p) < 0) {
+            printf("잘못된 라인 그룹: %s\n", argv[i]);
+            return 1;
+        }
+        if (npairs == 0 && peer.node >= 0) {
+            p->peer = &peer;
+            p->open_drain = 1;
+        }
+
+        for (int s = 0; s < p->nsrc; s++) {
+            p->value_fd[s] = open_sim_attr(dev_name, chip_name, p->src[s], "value", O_RDONLY);
+            if (p->value_fd[s] < 0) return 1;
+            if (p->open_drain) {
+                p->src_pull_fd[s] = open_sim_attr(dev_name, chip_name, p->src[s], "pull", O_WRONLY);
+                if (p->src_pull_fd[s] < 0 || set_pull(p->src_pull_fd[s], '1') < 0) return 1;
+                p->src_pull[s] = '1';
+            }
+        }
+        p->pull_fd = open_sim_attr(dev_name, chip_name, p->dst, "pull", O_WRONLY);
+        if (p->pull_fd < 0) {
+            return 1;
+        }
+
+        /* 공유선은 풀업에서 시작 (gpio-sim 기본 pull-down이면 놓인 선이 계속 펄스로 보임) */
+        if (p->open_drain) {
+            if (set_pull(p->pull_fd, '1') < 0) return 1;
+            p->last = '1';
+        } else {
+            p->last = 0;
+        }
+        npairs++;
+    }
+
+    /* 공유선 src의 방향(출력/입력) 조회용 */
+    char chip_path[64];
+    snprintf(chip_path, sizeof(chip_path), "/dev/%s", chip_name);
+    int chip_fd = open(chip_path, O_RDONLY);
+    if (chip_fd < 0) {
+        perror("gpiochip 열기 실패");
+        return 1;
+    }
+
+    signal(SIGINT, signal_handler);
+    signal(SIGTERM, signal_handler);
+    srand(time(NULL));
+
+    printf("gpio-sim 브리지 시작 (%d그룹, Ctrl+C로 종료)\n", npairs);
+    if (peer.node >= 0) {
+        printf("가상 송신기: 노드 %d, 단위 %llu us\n", peer.node,
+               (unsigned long long)(peer.unit_ns / 1000));
+    }
+    fflush(stdout);
+
+    while (running) {
+        uint64_t now = now_ns();
+
+        for (int i = 0; i < npairs; i++) {
+            struct bridge_pair *p = &pairs[i];
+            char c;
+
+            if (p->open_drain) {
+                bridge_open_drain(chip_fd, p, now);
+                continue;
+            }
+
+            if (pread(p->value_fd[0], &c, 1, 0) != 1 || c == p->last) {
+                continue;
+            }
+
+            if (set_pull(p->pull_fd, c) == 0) {
+                p->last = c;
+            }
+        }
+        usleep(POLL_US);
+    }
+
+    if (peer.node >= 0) {
+        printf("가상 송신기 노드 %d: 전송 %lu, 충돌 %lu, 선 사용 중 %lu, 백오프 %lu, 포기 %lu\n",
+               peer.node, peer.sent, peer.collisions, peer.lbt_busy, peer.backoffs, peer.aborts);
+    }
+
+    for (int i = 0; i < npairs; i++) {
+        for (int s = 0; s < pairs[i].nsrc; s++) {
+            close(pairs[i].value_fd[s]);
+            if (pairs[i].open_drain) close(pairs[i].src_pull_fd[s]);
+        }
+        close(pairs[i].pull_fd);
+    }
+    close(chip_fd);
+
+    printf("gpio-sim 브리지 종료\n");
+    return 0;
+}
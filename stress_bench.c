@@ -0,0 +1,675 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <string.h>
+#include <sys/ioctl.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <signal.h>
+#include <errno.h>
+#include <time.h>
+#include <sys/socket.h>
+#include <linux/netlink.h>
+#include <linux/genetlink.h>
+
+/*
+ * 제어 경로 경합 스트레스/벤치마크
+ * ioctl 스레드 M개, sysfs 읽기 스레드 K개, netlink 스냅샷 스레드 N개, 이벤트 생산자 1개를
+ * 동시에 돌려 초당 처리량, 부하 중 이벤트 경로 지연 백분위, 비정상 스냅샷 수를 출력한다.
+ * netlink GET은 인원/임계값/환기를 한 번에 돌려주므로 환기 == (인원 >= 임계값)을 확인해
+ * 필드 사이가 어긋난 스냅샷을 잡는다. 모든 스레드를 멈춘 뒤에도 한 번 더 확인.
+ * 비정상 스냅샷이 하나라도 있으면 종료 코드 1 (드라이버 변경 게이트용).
+ */
+
+#define TX_DEVICE_PATH "/dev/crowd_gpio0"
+#define RX_DEVICE_PATH "/dev/crowd_gpio1"
+#define SYSFS_DIR "/sys/class/crowd_monitor/crowd_gpio1"
+#define GPIO_IOCTL_SET_MODE _IOW('C', 1, int)
+#define GPIO_IOCTL_GET_COUNT _IOR('C', 2, int)
+#define GPIO_IOCTL_RESET_COUNT _IO('C', 3)
+#define GPIO_IOCTL_SET_THRESHOLD _IOW('C', 4, int)
+#define MODE_TRANSMITTER 1
+#define MODE_RECEIVER 2
+#define RX_CHANNEL 1
+
+/* 드라이버 gpio_drv.c와 동일한 netlink 정의 */
+#define CROWD_NL_FAMILY_NAME "crowd_monitor"
+#define CROWD_NL_CMD_GET 1
+
+enum {
+    CROWD_NL_ATTR_UNSPEC,
+    CROWD_NL_ATTR_PAD,
+    CROWD_NL_ATTR_CHANNEL,
+    CROWD_NL_ATTR_ZONE,
+    CROWD_NL_ATTR_DELTA,
+    CROWD_NL_ATTR_OCCUPANCY,
+    CROWD_NL_ATTR_THRESHOLD,
+    CROWD_NL_ATTR_VENTILATION,
+    CROWD_NL_ATTR_TIMESTAMP,
+    CROWD_NL_ATTR_MODE,
+    __CROWD_NL_ATTR_MAX,
+};
+
+#define NL_BUF_SIZE 4096
+#define GENL_ATTRS(nlh) ((struct nlattr *)((char *)NLMSG_DATA(nlh) + GENL_HDRLEN))
+#define GENL_ATTRS_LEN(nlh) ((int)(nlh)->nlmsg_len - NLMSG_LENGTH(GENL_HDRLEN))
+#define NLA_DATA(nla) ((void *)((char *)(nla) + NLA_HDRLEN))
+#define NLA_OK(nla, len) ((len) >= (int)sizeof(struct nlattr) && \
+                          (nla)->nla_len >= sizeof(struct nlattr) && (nla)->nla_len <= (len))
+#define NLA_NEXT(nla, len) ((len) -= NLA_ALIGN((nla)->nla_len), \
+                            (struct nlattr *)((char *)(nla) + NLA_ALIGN((nla)->nla_len)))
+
+#define MAX_THREADS 64
+#define MAX_LATENCY_SAMPLES 1000000
+#define RESET_EVERY 64          /* ioctl 스레드: 64번 중 1번 RESET */
+
+/* SET_THRESHOLD 스레드가 쓰는 값 (sysfs에서 이 밖의 값이 보이면 비정상) */
+static const int threshold_values[] = { 5, 10, 20, 50, 100 };
+#define NUM_THRESHOLDS (sizeof(threshold_values) / sizeof(threshold_values[0]))
+
+struct op_stats {
+    atomic_ulong ops;
+    atomic_ulong errors;
+};
+
+static atomic_int running = 1;
+static int initial_threshold = 50;
+
+static struct op_stats get_count_stats, set_threshold_stats, reset_stats;
+static struct op_stats sysfs_stats, netlink_stats, event_stats;
+static uint16_t nl_family_id;
+static atomic_ulong inconsistent;
+static atomic_ulong enters_issued;
+
+static uint64_t *latency_ns;
+static atomic_ulong latency_count;
+
+/* 루프백 모드: 송신 시각 FIFO (생산자 → 소비자) */
+static uint64_t *sent_at;
+static atomic_ulong sent_head, sent_tail;
+
+void signal_handler(int sig) {
+    running = 0;
+}
+
+uint64_t now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+void record_latency(uint64_t ns) {
+    unsigned long idx = atomic_fetch_add(&latency_count, 1);
+    if (idx < MAX_LATENCY_SAMPLES) {
+        latency_ns[idx] = ns;
+    }
+}
+
+void report_inconsistent(const char *what, const char *detail) {
+    unsigned long n = atomic_fetch_add(&inconsistent, 1);
+    if (n < 10) {
+        printf("  ✗ 비정상 스냅샷: %s (%s)\n", what, detail);
+    }
+}
+
+int threshold_allowed(int value) {
+    if (value == initial_threshold) return 1;
+    for (size_t i = 0; i < NUM_THRESHOLDS; i++) {
+        if (threshold_values[i] == value) return 1;
+    }
+    return 0;
+}
+
+void print_usage(const char *prog_name) {
+    printf("사용법: %s [옵션]\n", prog_name);
+    printf("옵션:\n");
+    printf("  -m N          ioctl 스레드 수 (기본 4)\n");
+    printf("  -k N          sysfs 읽기 스레드 수 (기본 2)\n");
+    printf("  -n N          netlink 스냅샷 스레드 수 (기본 1)\n");
+    printf("  -t SEC        측정 시간 (기본 10)\n");
+    printf("  -r N          이벤트 생산 속도 (events/s, 기본 0: 최대)\n");
+    printf("  -l, --loopback  송신 디바이스 → 링크 → 수신 read까지 종단 지연 측정\n");
+    printf("                (기본: 수신 디바이스에 직접 write, update_occupancy 경로)\n");
+    printf("  -h, --help    도움말\n");
+}
+
+/* ========== ioctl 스레드 ========== */
+
+void *ioctl_thread(void *arg) {
+    unsigned int seed = (unsigned int)(uintptr_t)arg;
+    int fd = open(RX_DEVICE_PATH, O_RDWR);
+    if (fd < 0) {
+        perror("ioctl 스레드: 디바이스 열기 실패");
+        return NULL;
+    }
+
+    for (unsigned long i = 0; running; i++) {
+        int value;
+        int op = rand_r(&seed) % RESET_EVERY;
+
+        if (op == 0) {
+            atomic_fetch_add(&reset_stats.ops, 1);
+            if (ioctl(fd, GPIO_IOCTL_RESET_COUNT) < 0) {
+                atomic_fetch_add(&reset_stats.errors, 1);
+            }
+        } else if (op % 2 == 0) {
+            value = threshold_values[rand_r(&seed) % NUM_THRESHOLDS];
+            atomic_fetch_add(&set_threshold_stats.ops, 1);
+            if (ioctl(fd, GPIO_IOCTL_SET_THRESHOLD, &value) < 0) {
+                atomic_fetch_add(&set_threshold_stats.errors, 1);
+            }
+        } else {
+            atomic_fetch_add(&get_count_stats.ops, 1);
+            if (ioctl(fd, GPIO_IOCTL_GET_COUNT, &value) < 0) {
+                atomic_fetch_add(&get_count_stats.errors, 1);
+                continue;
+            }
+
+            /* RESET이 섞여도 인원은 0 이상, 지금까지 보낸 ENTER 수 이하 */
+            if (value < 0 || (unsigned long)value > atomic_load(&enters_issued)) {
+                char detail[64];
+                snprintf(detail, sizeof(detail), "GET_COUNT=%d", value);
+                report_inconsistent("ioctl 인원", detail);
+            }
+        }
+    }
+
+    close(fd);
+    return NULL;
+}
+
+/* ========== sysfs 읽기 스레드 ========== */
+
+int read_sysfs(const char *name, char *buf, size_t size) {
+    char path[128];
+    snprintf(path, sizeof(path), SYSFS_DIR "/%s", name);
+
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) return -1;
+
+    ssize_t n = read(fd, buf, size - 1);
+    close(fd);
+    if (n <= 0) return -1;
+
+    buf[n] = '\0';
+    return 0;
+}
+
+/* 개행으로 끝나는 정수 한 개인지 확인 */
+int parse_sysfs_int(const char *buf, int *value) {
+    char *end;
+    long v = strtol(buf, &end, 10);
+    if (end == buf || strcmp(end, "\n") != 0) return -1;
+    *value = (int)v;
+    return 0;
+}
+
+void *sysfs_thread(void *arg) {
+    char buf[256];
+
+    while (running) {
+        int occupancy, threshold;
+
+        atomic_fetch_add(&sysfs_stats.ops, 1);
+        if (read_sysfs("occupancy", buf, sizeof(buf)) < 0) {
+            atomic_fetch_add(&sysfs_stats.errors, 1);
+            continue;
+        }
+        if (parse_sysfs_int(buf, &occupancy) < 0 || occupancy < 0 ||
+            (unsigned long)occupancy > atomic_load(&enters_issued)) {
+            buf[strcspn(buf, "\n")] = 0;
+            report_inconsistent("sysfs occupancy", buf);
+        }
+
+        atomic_fetch_add(&sysfs_stats.ops, 1);
+        if (read_sysfs("threshold", buf, sizeof(buf)) < 0) {
+            atomic_fetch_add(&sysfs_stats.errors, 1);
+            continue;
+        }
+        if (parse_sysfs_int(buf, &threshold) < 0 || !threshold_allowed(threshold)) {
+            buf[strcspn(buf, "\n")] = 0;
+            report_inconsistent("sysfs threshold", buf);
+        }
+
+        atomic_fetch_add(&sysfs_stats.ops, 1);
+        if (read_sysfs("mode", buf, sizeof(buf)) < 0) {
+            atomic_fetch_add(&sysfs_stats.errors, 1);
+            continue;
+        }
+        if (strcmp(buf, "receiver\n") != 0) {
+            buf[strcspn(buf, "\n")] = 0;
+            report_inconsistent("sysfs mode", buf);
+        }
+    }
+
+    return NULL;
+}
+
+/* ========== netlink 스냅샷 스레드 ========== */
+
+struct nl_snapshot {
+    int occupancy;
+    int threshold;
+    int ventilation;
+};
+
+void parse_attrs(struct nlattr *nla, int len, struct nlattr **tb, int max) {
+    memset(tb, 0, sizeof(*tb) * (max + 1));
+    for (; NLA_OK(nla, len); nla = NLA_NEXT(nla, len)) {
+        int type = nla->nla_type & NLA_TYPE_MASK;
+        if (type <= max) tb[type] = nla;
+    }
+}
+
+/* genl 요청 한 건 (속성 하나) 전송 후 같은 seq의 응답 메시지를 buf로 받음 */
+struct nlmsghdr *nl_request(int sock, char *buf, uint16_t family, uint8_t cmd,
+                            int attr, const void *data, int len) {
+    static atomic_uint seq_counter = 1;
+    struct sockaddr_nl addr = { .nl_family = AF_NETLINK };
+    struct nlmsghdr *nlh = (struct nlmsghdr *)buf;
+    struct genlmsghdr *genl = NLMSG_DATA(nlh);
+    struct nlattr *nla = GENL_ATTRS(nlh);
+    uint32_t seq = atomic_fetch_add(&seq_counter, 1);
+
+    memset(buf, 0, NLMSG_LENGTH(GENL_HDRLEN) + NLA_HDRLEN + NLA_ALIGN(len));
+    nla->nla_type = attr;
+    nla->nla_len = NLA_HDRLEN + len;
+    memcpy(NLA_DATA(nla), data, len);
+    nlh->nlmsg_len = NLMSG_LENGTH(GENL_HDRLEN) + NLA_ALIGN(nla->nla_len);
+    nlh->nlmsg_type = family;
+    nlh->nlmsg_flags = NLM_F_REQUEST;
+    nlh->nlmsg_seq = seq;
+    genl->cmd = cmd;
+    genl->version = 1;
+
+    if (sendto(sock, nlh, nlh->nlmsg_len, 0, (struct sockaddr *)&addr, sizeof(addr)) < 0) {
+        return NULL;
+    }
+
+    for (;;) {
+        int n = recv(sock, buf, NL_BUF_SIZE, 0);
+        if (n < 0) return NULL;
+
+        nlh = (struct nlmsghdr *)buf;
+        if (!NLMSG_OK(nlh, n)) return NULL;
+        if (nlh->nlmsg_seq != seq) continue;
+        return nlh->nlmsg_type == NLMSG_ERROR ? NULL : nlh;
+    }
+}
+
+int resolve_family(void) {
+    char buf[NL_BUF_SIZE];
+    int sock = socket(AF_NETLINK, SOCK_RAW, NETLINK_GENERIC);
+    if (sock < 0) return -1;
+
+    struct nlmsghdr *nlh = nl_request(sock, buf, GENL_ID_CTRL, CTRL_CMD_GETFAMILY,
+                                      CTRL_ATTR_FAMILY_NAME, CROWD_NL_FAMILY_NAME,
+                                      strlen(CROWD_NL_FAMILY_NAME) + 1);
+    close(sock);
+    if (!nlh) return -1;
+
+    struct nlattr *tb[CTRL_ATTR_MAX + 1];
+    parse_attrs(GENL_ATTRS(nlh), GENL_ATTRS_LEN(nlh), tb, CTRL_ATTR_MAX);
+    if (!tb[CTRL_ATTR_FAMILY_ID]) return -1;
+
+    nl_family_id = *(uint16_t *)NLA_DATA(tb[CTRL_ATTR_FAMILY_ID]);
+    return 0;
+}
+
+/* 수신 채널 상태를 한 번에 조회 (드라이버가 device_lock 안에서 찍은 스냅샷) */
+int nl_get_snapshot(int sock, struct nl_snapshot *snap) {
+    char buf[NL_BUF_SIZE];
+    uint32_t channel = RX_CHANNEL;
+    struct nlattr *tb[__CROWD_NL_ATTR_MAX];
+
+    struct nlmsghdr *nlh = nl_request(sock, buf, nl_family_id, CROWD_NL_CMD_GET,
+                                      CROWD_NL_ATTR_CHANNEL, &channel, sizeof(channel));
+    if (!nlh) return -1;
+
+    parse_attrs(GENL_ATTRS(nlh), GENL_ATTRS_LEN(nlh), tb, __CROWD_NL_ATTR_MAX - 1);
+    if (!tb[CROWD_NL_ATTR_OCCUPANCY] || !tb[CROWD_NL_ATTR_THRESHOLD] ||
+        !tb[CROWD_NL_ATTR_VENTILATION]) {
+        return -1;
+    }
+
+    snap->occupancy = *(int32_t *)NLA_DATA(tb[CROWD_NL_ATTR_OCCUPANCY]);
+    snap->threshold = *(int32_t *)NLA_DATA(tb[CROWD_NL_ATTR_THRESHOLD]);
+    snap->ventilation = *(uint8_t *)NLA_DATA(tb[CROWD_NL_ATTR_VENTILATION]);
+    return 0;
+}
+
+/* 한 스냅샷 안의 필드끼리 맞는지 확인 (RESET과 임계값 변경이 섞여도 항상 성립해야 함) */
+void check_snapshot(const char *what, const struct nl_snapshot *snap) {
+    char detail[96];
+
+    if (snap->occupancy >= 0 && (unsigned long)snap->occupancy <= atomic_load(&enters_issued) &&
+        threshold_allowed(snap->threshold) &&
+        snap->ventilation == (snap->occupancy >= snap->threshold)) {
+        return;
+    }
+
+    snprintf(detail, sizeof(detail), "인원=%d 임계값=%d 환기=%d",
+             snap->occupancy, snap->threshold, snap->ventilation);
+    report_inconsistent(what, detail);
+}
+
+void *netlink_thread(void *arg) {
+    int sock = socket(AF_NETLINK, SOCK_RAW, NETLINK_GENERIC);
+    if (sock < 0) {
+        perror("netlink 스레드: 소켓 생성 실패");
+        return NULL;
+    }
+
+    while (running) {
+        struct nl_snapshot snap;
+
+        atomic_fetch_add(&netlink_stats.ops, 1);
+        if (nl_get_snapshot(sock, &snap) < 0) {
+            if (errno != EINTR) atomic_fetch_add(&netlink_stats.errors, 1);
+            continue;
+        }
+        check_snapshot("netlink 스냅샷", &snap);
+    }
+
+    close(sock);
+    return NULL;
+}
+
+/* ========== 이벤트 생산자 / 소비자 ========== */
+
+void sleep_until(uint64_t deadline) {
+    struct timespec ts = {
+        .tv_sec = deadline / 1000000000ULL,
+        .tv_nsec = deadline % 1000000000ULL,
+    };
+    clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, NULL);
+}
+
+struct producer_args {
+    int fd;
+    int rate;
+    int loopback;
+};
+
+void *producer_thread(void *arg) {
+    struct producer_args *p = arg;
+    uint64_t interval = p->rate > 0 ? 1000000000ULL / p->rate : 0;
+    uint64_t next = now_ns();
+
+    /* ENTER 두 번에 EXIT 한 번 (인원이 늘어 환기 임계값을 넘나들게 함) */
+    static const char *const pattern[] = { "ENTER", "ENTER", "EXIT" };
+
+    for (unsigned long i = 0; running; i++) {
+        const char *cmd = pattern[i % 3];
+        int is_enter = cmd[1] == 'N';
+
+        if (interval) {
+            next += interval;
+            sleep_until(next);
+        }
+
+        /* 검사 스레드가 ENTER 수 상한을 넘는 값으로 오판하지 않게 먼저 증가 */
+        if (is_enter) atomic_fetch_add(&enters_issued, 1);
+
+        uint64_t start = now_ns();
+        if (p->loopback) {
+            sent_at[atomic_load(&sent_head) % MAX_LATENCY_SAMPLES] = start;
+            atomic_fetch_add(&sent_head, 1);
+        }
+
+        atomic_fetch_add(&event_stats.ops, 1);
+        if (write(p->fd, cmd, strlen(cmd)) < 0) {
+            if (errno != EINTR) atomic_fetch_add(&event_stats.errors, 1);
+            continue;
+        }
+
+        if (!p->loopback) {
+            record_latency(now_ns() - start);
+        }
+    }
+
+    return NULL;
+}
+
+/* 루프백 모드: 수신 디바이스에서 이벤트를 읽어 송신 시각과 짝지음 */
+void *consumer_thread(void *arg) {
+    int fd = *(int *)arg;
+    char buf[256];
+
+    while (running) {
+        ssize_t n = read(fd, buf, sizeof(buf) - 1);
+        if (n <= 0) continue;
+
+        buf[n] = '\0';
+        for (char *line = strtok(buf, "\n"); line; line = strtok(NULL, "\n")) {
+            if (atomic_load(&sent_tail) >= atomic_load(&sent_head)) break;
+
+            unsigned long idx = atomic_fetch_add(&sent_tail, 1);
+            record_latency(now_ns() - sent_at[idx % MAX_LATENCY_SAMPLES]);
+        }
+    }
+
+    return NULL;
+}
+
+/* ========== 결과 ========== */
+
+int compare_u64(const void *a, const void *b) {
+    uint64_t x = *(const uint64_t *)a, y = *(const uint64_t *)b;
+    return (x > y) - (x < y);
+}
+
+void print_ops(const char *name, struct op_stats *s, double elapsed) {
+    unsigned long ops = atomic_load(&s->ops);
+    printf("  %-16s %10lu회  %10.0f ops/s  (오류 %lu)\n",
+           name, ops, ops / elapsed, atomic_load(&s->errors));
+}
+
+int main(int argc, char *argv[]) {
+    int num_ioctl = 4;
+    int num_sysfs = 2;
+    int num_netlink = 1;
+    int duration = 10;
+    int rate = 0;
+    int loopback = 0;
+
+    // 명령행 인수 처리
+    for (int i = 1; i < argc; i++) {
+        const char *val = (i + 1 < argc) ? argv[i + 1] : NULL;
+
+        if (strcmp(argv[i], "-m") == 0 && val) {
+            num_ioctl = atoi(val); i++;
+        } else if (strcmp(argv[i], "-k") == 0 && val) {
+            num_sysfs = atoi(val); i++;
+        } else if (strcmp(argv[i], "-n") == 0 && val) {
+            num_netlink = atoi(val); i++;
+        } else if (strcmp(argv[i], "-t") == 0 && val) {
+            duration = atoi(val); i++;
+        } else if (strcmp(argv[i], "-r") == 0 && val) {
+            rate = atoi(val); i++;
+        } else if (strcmp(argv[i], "-l") == 0 || strcmp(argv[i], "--loopback") == 0) {
+            loopback = 1;
+        } else if (strcmp(argv[i], "-h") == 0 || strcmp(argv[i], "--help") == 0) {
+            print_usage(argv[0]);
+            return 0;
+        } else {
+            print_usage(argv[0]);
+            return 1;
+        }
+    }
+
+    if (num_ioctl < 0 || num_ioctl > MAX_THREADS || num_sysfs < 0 || num_sysfs > MAX_THREADS ||
+        num_netlink < 0 || num_netlink > MAX_THREADS || duration <= 0) {
+        printf("잘못된 인수\n");
+        return 1;
+    }
+
+    printf("IoT 혼잡도 시스템 - 제어 경로 경합 벤치마크\n");
+    printf("ioctl 스레드 %d개, sysfs 스레드 %d개, netlink 스레드 %d개, 이벤트 생산자 1개 (%s), %d초\n",
+           num_ioctl, num_sysfs, num_netlink, loopback ? "루프백" : "직접 write", duration);
+    printf("=====================================\n");
+
+    latency_ns = calloc(MAX_LATENCY_SAMPLES, sizeof(uint64_t));
+    sent_at = calloc(MAX_LATENCY_SAMPLES, sizeof(uint64_t));
+    if (!latency_ns || !sent_at) {
+        perror("메모리 할당 실패");
+        return 1;
+    }
+
+    /* 수신 디바이스를 수신 모드로 두고 인원 초기화 */
+    int rx_fd = open(RX_DEVICE_PATH, O_RDWR);
+    if (rx_fd < 0) {
+        perror("수신 디바이스 열기 실패");
+        printf("드라이버 로드: sudo make load (또는 make sim-load)\n");
+        return 1;
+    }
+
+    int mode = MODE_RECEIVER;
+    if (ioctl(rx_fd, GPIO_IOCTL_SET_MODE, &mode) < 0 ||
+        ioctl(rx_fd, GPIO_IOCTL_RESET_COUNT) < 0) {
+        perror("수신 디바이스 설정 실패");
+        return 1;
+    }
+
+    char buf[64];
+    if (read_sysfs("threshold", buf, sizeof(buf)) == 0) {
+        parse_sysfs_int(buf, &initial_threshold);
+    }
+
+    if (resolve_family() < 0) {
+        printf("netlink 패밀리 %s 조회 실패\n", CROWD_NL_FAMILY_NAME);
+        return 1;
+    }
+
+    struct producer_args producer = { .fd = rx_fd, .rate = rate, .loopback = loopback };
+    int tx_fd = -1;
+
+    if (loopback) {
+        tx_fd = open(TX_DEVICE_PATH, O_RDWR);
+        mode = MODE_TRANSMITTER;
+        if (tx_fd < 0 || ioctl(tx_fd, GPIO_IOCTL_SET_MODE, &mode) < 0) {
+            perror("송신 디바이스 설정 실패");
+            return 1;
+        }
+        producer.fd = tx_fd;
+    }
+
+    /* SA_RESTART 없이 등록해 블로킹 read/write가 종료 신호로 깨어나게 함 */
+    struct sigaction sa;
+    memset(&sa, 0, sizeof(sa));
+    sa.sa_handler = signal_handler;
+    sigaction(SIGINT, &sa, NULL);
+    sigaction(SIGALRM, &sa, NULL);
+
+    pthread_t threads[3 * MAX_THREADS + 2];
+    int nthreads = 0;
+    int ret = 0;
+    uint64_t start = now_ns();
+
+    for (int i = 0; i < num_ioctl && ret == 0; i++) {
+        ret = pthread_create(&threads[nthreads], NULL, ioctl_thread, (void *)(uintptr_t)(i + 1));
+        if (ret == 0) nthreads++;
+    }
+    for (int i = 0; i < num_sysfs && ret == 0; i++) {
+        ret = pthread_create(&threads[nthreads], NULL, sysfs_thread, NULL);
+        if (ret == 0) nthreads++;
+    }
+    for (int i = 0; i < num_netlink && ret == 0; i++) {
+        ret = pthread_create(&threads[nthreads], NULL, netlink_thread, NULL);
+        if (ret == 0) nthreads++;
+    }
+    if (ret == 0) {
+        ret = pthread_create(&threads[nthreads], NULL, producer_thread, &producer);
+        if (ret == 0) nthreads++;
+    }
+    if (ret == 0 && loopback) {
+        ret = pthread_create(&threads[nthreads], NULL, consumer_thread, &rx_fd);
+        if (ret == 0) nthreads++;
+    }
+
+    /* 일부만 만들어진 채로 측정하면 결과가 의미 없으므로 만든 스레드만 정리하고 실패 */
+    if (ret != 0) {
+        printf("스레드 생성 실패: %s\n", strerror(ret));
+        running = 0;
+    } else {
+        alarm(duration);
+    }
+    while (running) {
+        pause();
+    }
+
+    /* 블로킹 중인 스레드를 깨움 */
+    for (int i = 0; i < nthreads; i++) {
+        pthread_kill(threads[i], SIGALRM);
+    }
+    for (int i = 0; i < nthreads; i++) {
+        pthread_join(threads[i], NULL);
+    }
+    if (ret != 0) {
+        return 1;
+    }
+
+    double elapsed = (now_ns() - start) / 1e9;
+
+    printf("\n=== 처리량 (%.1f초) ===\n", elapsed);
+    print_ops("GET_COUNT", &get_count_stats, elapsed);
+    print_ops("SET_THRESHOLD", &set_threshold_stats, elapsed);
+    print_ops("RESET", &reset_stats, elapsed);
+    print_ops("sysfs read", &sysfs_stats, elapsed);
+    print_ops("netlink GET", &netlink_stats, elapsed);
+    print_ops("event write", &event_stats, elapsed);
+
+    unsigned long count = atomic_load(&latency_count);
+    if (count > MAX_LATENCY_SAMPLES) count = MAX_LATENCY_SAMPLES;
+
+    printf("\n=== 이벤트 경로 지연 (%s, 샘플 %lu개) ===\n",
+           loopback ? "송신 write → 수신 read" : "수신 디바이스 write", count);
+    if (count > 0) {
+        qsort(latency_ns, count, sizeof(uint64_t), compare_u64);
+        printf("  p50 %.1f us  p90 %.1f us  p99 %.1f us  p99.9 %.1f us  max %.1f us\n",
+               latency_ns[count / 2] / 1e3,
+               latency_ns[count * 90 / 100] / 1e3,
+               latency_ns[count * 99 / 100] / 1e3,
+               latency_ns[count * 999 / 1000] / 1e3,
+               latency_ns[count - 1] / 1e3);
+    }
+
+    /*
+     * 모든 스레드가 멈춘 뒤: 루프백이면 링크에 남은 프레임이 반영되도록 잠깐 기다린 다음
+     * netlink 스냅샷과 GET_COUNT, sysfs가 같은 인원을 보여야 함
+     */
+    if (loopback) usleep(200000);
+
+    struct nl_snapshot snap;
+    int nl_sock = socket(AF_NETLINK, SOCK_RAW, NETLINK_GENERIC);
+    int count_value, sysfs_value;
+
+    if (nl_sock < 0 || nl_get_snapshot(nl_sock, &snap) < 0 ||
+        ioctl(rx_fd, GPIO_IOCTL_GET_COUNT, &count_value) < 0 ||
+        read_sysfs("occupancy", buf, sizeof(buf)) < 0 || parse_sysfs_int(buf, &sysfs_value) < 0) {
+        report_inconsistent("정지 후 스냅샷", "조회 실패");
+    } else {
+        char detail[96];
+
+        check_snapshot("정지 후 스냅샷", &snap);
+        if (count_value != snap.occupancy || sysfs_value != snap.occupancy) {
+            snprintf(detail, sizeof(detail), "netlink=%d GET_COUNT=%d sysfs=%d",
+                     snap.occupancy, count_value, sysfs_value);
+            report_inconsistent("정지 후 인원", detail);
+        }
+    }
+    if (nl_sock >= 0) close(nl_sock);
+
+    unsigned long bad = atomic_load(&inconsistent);
+    printf("\n=== 일관성 ===\n");
+    printf("  비정상 스냅샷: %lu개 %s\n", bad, bad ? "✗" : "✓");
+
+    if (tx_fd >= 0) close(tx_fd);
+    close(rx_fd);
+    free(latency_ns);
+    free(sent_at);
+
+    return bad ? 1 : 0;
+}
\ No newline at end of file
@@ -25,6 +25,7 @@ void print_usage(const char *prog_name) {
     printf("옵션:\n");
     printf("  -a, --auto    자동 모드 (기본)\n");
     printf("  -m, --manual  수동 모드\n");
+    printf("  -i, --interval MS  자동 모드 전송 간격 (기본 %d, 0: 링크 최대 속도)\n", DELAY_MS);
     printf("  -h, --help    도움말\n");
     printf("\n");
     printf("수동 모드 명령어:\n");
@@ -36,6 +37,7 @@ void print_usage(const char *prog_name) {
 
 int main(int argc, char *argv[]) {
     int auto_mode = 1;
+    int interval_ms = DELAY_MS;
     
     // 명령행 인수 처리
     for (int i = 1; i < argc; i++) {
@@ -43,6 +45,8 @@ int main(int argc, char *argv[]) {
             auto_mode = 0;
         } else if (strcmp(argv[i], "-a") == 0 || strcmp(argv[i], "--auto") == 0) {
             auto_mode = 1;
+        } else if ((strcmp(argv[i], "-i") == 0 || strcmp(argv[i], "--interval") == 0) && i + 1 < argc) {
+            interval_ms = atoi(argv[++i]);
         } else if (strcmp(argv[i], "-h") == 0 || strcmp(argv[i], "--help") == 0) {
             print_usage(argv[0]);
             return 0;
@@ -65,8 +69,9 @@ int main(int argc, char *argv[]) {
         return 1;
     }
     
-    // 송신 모드로 설정
-    if (ioctl(fd, GPIO_IOCTL_SET_MODE, MODE_TRANSMITTER) < 0) {
+    // 송신 모드로 설정 (드라이버는 int 포인터를 받음)
+    int mode = MODE_TRANSMITTER;
+    if (ioctl(fd, GPIO_IOCTL_SET_MODE, &mode) < 0) {
         perror("송신 모드 설정 실패");
         close(fd);
         return 1;
@@ -74,7 +79,7 @@ int main(int argc, char *argv[]) {
     
     // 임계값 설정 (50명)
     int threshold = 50;
-    if (ioctl(fd, GPIO_IOCTL_SET_THRESHOLD, threshold) == 0) {
+    if (ioctl(fd, GPIO_IOCTL_SET_THRESHOLD, &threshold) == 0) {
         printf("임계값 설정: %d명\n", threshold);
     }
     
@@ -114,7 +119,9 @@ int main(int argc, char *argv[]) {
             printf("[%03d] %s 신호 전송 (시뮬레이션 인원: %d명)\n", 
                    ++count, cmd, people_sim);
             
-            usleep(DELAY_MS * 1000);
+            if (interval_ms > 0) {
+                usleep(interval_ms * 1000);
+            }
         }
         
     } else {